@@ -1,407 +1,4389 @@
 #include <bits/stdc++.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
-#define RESET   "\033[0m"
-#define BOLD    "\033[1m"
-#define RED     "\033[31m"
-#define GREEN   "\033[32m"
-#define YELLOW  "\033[33m"
-#define CYAN    "\033[36m"
-#define MAGENTA "\033[35m"
+// Cleared by --plain, NO_COLOR, or when stdout is not a terminal.
+static bool colorOutput = true;
 
-using sys_time = chrono::system_clock::time_point;
+// ---------- Themes ----------
+// Text that never changes (headers, the menu, fixed messages) is rendered at compile time
+// once per theme into a FixedString, so printing it is one write of a static string;
+// colorOutput only picks the Color or Plain rendering. Messages with runtime values use
+// the RED / GREEN / ... macros below, which take their codes from the same theme.
+template <size_t N>
+struct FixedString {
+    char s[N + 1] = {};
+    constexpr FixedString() = default;
+    constexpr FixedString(const char (&lit)[N + 1]) { for (size_t i = 0; i < N; ++i) s[i] = lit[i]; }
+    constexpr string_view view() const { return string_view(s, N); }
+};
+template <size_t N> FixedString(const char (&)[N]) -> FixedString<N - 1>;
+
+template <size_t A, size_t B>
+constexpr FixedString<A + B> operator+(const FixedString<A> &a, const FixedString<B> &b) {
+    FixedString<A + B> out;
+    for (size_t i = 0; i < A; ++i) out.s[i] = a.s[i];
+    for (size_t i = 0; i < B; ++i) out.s[A + i] = b.s[i];
+    return out;
+}
+
+struct ColorTheme {
+    static constexpr FixedString<4> reset{"\033[0m"}, bold{"\033[1m"};
+    static constexpr FixedString<5> red{"\033[31m"}, green{"\033[32m"}, yellow{"\033[33m"}, cyan{"\033[36m"}, magenta{"\033[35m"};
+};
+struct PlainTheme {
+    static constexpr FixedString<0> reset{}, bold{}, red{}, green{}, yellow{}, cyan{}, magenta{};
+};
+
+enum class Tone { Bold, Red, Green, Yellow, Cyan };
+
+template <class Theme, Tone T> constexpr auto toneCode() {
+    if constexpr (T == Tone::Bold) return Theme::bold;
+    else if constexpr (T == Tone::Red) return Theme::red;
+    else if constexpr (T == Tone::Green) return Theme::green;
+    else if constexpr (T == Tone::Yellow) return Theme::yellow;
+    else return Theme::cyan;
+}
+
+// One full line in a tone: code, text, reset, newline.
+template <class Theme, Tone T, size_t N> constexpr auto styledLine(const char (&text)[N]) {
+    return toneCode<Theme, T>() + FixedString<N - 1>(text) + Theme::reset + FixedString("\n");
+}
+
+template <class Theme, size_t N> constexpr auto renderHeader(const char (&title)[N]) {
+    return Theme::bold + Theme::cyan + FixedString("\n╔════════════════════════════════════════════════════════╗\n  ")
+         + FixedString<N - 1>(title) + FixedString("\n╚════════════════════════════════════════════════════════╝\n") + Theme::reset;
+}
+
+// Evaluates a FixedString expression over `Theme` for both themes at compile time and
+// yields the one matching colorOutput, as a view of static storage.
+#define PT_THEMED(...)                                                                        \
+    ([]() -> string_view {                                                                    \
+        static constexpr auto color = [] { using Theme = ColorTheme; return __VA_ARGS__; }(); \
+        static constexpr auto plain = [] { using Theme = PlainTheme; return __VA_ARGS__; }(); \
+        return colorOutput ? color.view() : plain.view();                                     \
+    }())
+#define PT_HEADER(title) PT_THEMED(renderHeader<Theme>(title))
+#define PT_LINE(tone, text) PT_THEMED(styledLine<Theme, Tone::tone>(text))
+
+#define RESET   (colorOutput ? ColorTheme::reset.s : "")
+#define BOLD    (colorOutput ? ColorTheme::bold.s : "")
+#define RED     (colorOutput ? ColorTheme::red.s : "")
+#define GREEN   (colorOutput ? ColorTheme::green.s : "")
+#define YELLOW  (colorOutput ? ColorTheme::yellow.s : "")
+#define CYAN    (colorOutput ? ColorTheme::cyan.s : "")
+#define MAGENTA (colorOutput ? ColorTheme::magenta.s : "")
+
+// Calendar date stored as days since 1970-01-01 (proleptic Gregorian).
+// Date math is plain integer arithmetic; strings only exist at the CSV/console boundary.
+struct Date {
+    int32_t days = 0;
+    constexpr Date() = default;
+    constexpr explicit Date(int32_t d) : days(d) {}
+};
+
+constexpr bool operator==(Date a, Date b) { return a.days == b.days; }
+constexpr bool operator!=(Date a, Date b) { return a.days != b.days; }
+constexpr bool operator<(Date a, Date b) { return a.days < b.days; }
+constexpr bool operator>(Date a, Date b) { return a.days > b.days; }
+constexpr bool operator<=(Date a, Date b) { return a.days <= b.days; }
+constexpr bool operator>=(Date a, Date b) { return a.days >= b.days; }
+
+// days_from_civil / civil_from_days (H. Hinnant), no libc time calls involved
+constexpr Date dateFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return Date(era * 146097 + static_cast<int>(doe) - 719468);
+}
+
+constexpr void civilFromDate(Date dt, int &y, unsigned &m, unsigned &d) {
+    const int z = dt.days + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+}
+
+constexpr unsigned daysInMonth(int y, unsigned m) {
+    constexpr unsigned char dim[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return (m == 2 && leap) ? 29 : dim[m - 1];
+}
+
+struct CycleEntry {
+    Date startDate;
+    Date endDate;
+    int durationDays = 0;
+    int cycleLength = 0;
+    CycleEntry() = default;
+    CycleEntry(Date s, Date e, int d, int c)
+        : startDate(s), endDate(e), durationDays(d), cycleLength(c) {}
+};
+
+// Symptoms and mood are StringPool ids (0 = empty); the date is the key it is stored under.
+struct DailyLog { uint32_t symptoms = 0, mood = 0; };
+
+struct Reminder {
+    Date when;
+    uint32_t id = 0;
+    string message;
+    
+    bool operator==(const Reminder &o) const { return when == o.when && message == o.message; }
+};
+
+// trim helper
+static inline string_view trim(string_view s) {
+    size_t a = 0, b = s.size();
+    while (a < b && isspace((unsigned char)s[a])) ++a;
+    while (b > a && isspace((unsigned char)s[b-1])) --b;
+    return s.substr(a, b - a);
+}
+
+static inline bool parseInt(string_view s, int &v) {
+    auto r = from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == errc() && r.ptr == s.data() + s.size();
+}
+
+// Splits off the first whitespace-separated word of `rest`.
+static string_view nextWord(string_view &rest) {
+    size_t e = 0;
+    while (e < rest.size() && !isspace((unsigned char)rest[e])) ++e;
+    string_view w = rest.substr(0, e);
+    rest = trim(rest.substr(e));
+    return w;
+}
+
+// Parses YYYY-MM-DD (month/day may be one digit); rejects dates that do not exist.
+bool parseDate(string_view in, Date &out) {
+    size_t i = 0, n = in.size();
+    auto num = [&](int maxDigits, int &v) {
+        size_t b = i;
+        v = 0;
+        while (i < n && i - b < size_t(maxDigits) && in[i] >= '0' && in[i] <= '9') v = v * 10 + (in[i++] - '0');
+        return i > b;
+    };
+    int y, m, d;
+    if (!num(4, y) || i >= n || in[i++] != '-') return false;
+    if (!num(2, m) || i >= n || in[i++] != '-') return false;
+    if (!num(2, d) || i != n) return false;
+    if (m < 1 || m > 12 || d < 1 || unsigned(d) > daysInMonth(y, m)) return false;
+    out = dateFromCivil(y, m, d);
+    return true;
+}
+
+// "00" .. "99": formatting copies two digits at a time instead of dividing per digit.
+struct DigitPairs {
+    char c[200];
+    constexpr DigitPairs() : c() {
+        for (int i = 0; i < 100; ++i) { c[2 * i] = char('0' + i / 10); c[2 * i + 1] = char('0' + i % 10); }
+    }
+    const char *operator[](unsigned v) const { return c + 2 * v; }
+};
+static constexpr DigitPairs kDigitPairs;
+
+// Writes exactly 10 characters (YYYY-MM-DD) into out; no allocation.
+char *formatDate(Date dt, char *out) {
+    int y; unsigned m, d;
+    civilFromDate(dt, y, m, d);
+    unsigned uy = static_cast<unsigned>(y) % 10000;
+    memcpy(out, kDigitPairs[uy / 100], 2); memcpy(out + 2, kDigitPairs[uy % 100], 2);
+    out[4] = '-'; memcpy(out + 5, kDigitPairs[m], 2);
+    out[7] = '-'; memcpy(out + 8, kDigitPairs[d], 2);
+    return out + 10;
+}
+
+string dateToString(Date dt) {
+    char buf[10];
+    formatDate(dt, buf);
+    return string(buf, 10);
+}
+
+ostream &operator<<(ostream &os, Date dt) {
+    char buf[10];
+    formatDate(dt, buf);
+    return os << string_view(buf, 10);
+}
+
+// Local "today" as a day number, shared by every thread. A call is one time() read and a
+// compare; the calendar conversion (localtime_r, which unlike localtime is thread-safe)
+// only runs again once the cached day has passed local midnight.
+class DateService {
+    atomic<int64_t> validUntil{INT64_MIN}; // time_t at which `day` goes stale
+    atomic<int32_t> day{0};
+
+public:
+    static DateService &global() { static DateService service; return service; }
+
+    Date today() {
+        time_t now = time(nullptr);
+        if (int64_t(now) < validUntil.load(memory_order_acquire)) return Date(day.load(memory_order_relaxed));
+        tm local;
+        localtime_r(&now, &local);
+        Date d = dateFromCivil(local.tm_year + 1900, unsigned(local.tm_mon + 1), unsigned(local.tm_mday));
+        tm midnight = local;
+        midnight.tm_mday += 1;
+        midnight.tm_hour = midnight.tm_min = midnight.tm_sec = 0;
+        midnight.tm_isdst = -1;
+        time_t until = mktime(&midnight);
+        day.store(d.days, memory_order_relaxed);
+        validUntil.store(until > now ? int64_t(until) : int64_t(now) + 60, memory_order_release);
+        return d;
+    }
+};
+
+Date today() { return DateService::global().today(); }
+
+int daysBetween(Date d1, Date d2) { return d2.days - d1.days; }
+
+Date addDays(Date d, int days) { return Date(d.days + days); }
+
+int daysFromTodayTo(Date d) { return daysBetween(today(), d); }
+
+// ---------- String pool ----------
+// Symptoms and moods come from a small vocabulary, so each distinct text is stored once
+// per tracker and logs keep 32-bit ids. Id 0 is the empty string. Entries live as long
+// as the pool (their tracker), and a deque keeps them in place, so views handed out stay
+// valid until then. Evicting a tracker frees its texts with it.
+class StringPool {
+    mutable shared_mutex mu;
+    deque<string> strings{string()};
+    unordered_map<string_view, uint32_t> ids{{string_view(), 0}};
+    size_t textBytes = 0;
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    uint32_t intern(string_view s) {
+        if (s.empty()) return 0;
+        {
+            shared_lock<shared_mutex> lock(mu);
+            auto it = ids.find(s);
+            if (it != ids.end()) return it->second;
+        }
+        unique_lock<shared_mutex> lock(mu);
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        uint32_t id = uint32_t(strings.size());
+        ids.emplace(strings.emplace_back(s), id);
+        textBytes += s.size();
+        return id;
+    }
+
+    string_view str(uint32_t id) const {
+        shared_lock<shared_mutex> lock(mu);
+        return strings[id];
+    }
+
+    // Id of an already interned text, without adding it.
+    optional<uint32_t> lookup(string_view s) const {
+        shared_lock<shared_mutex> lock(mu);
+        auto it = ids.find(s);
+        return it == ids.end() ? nullopt : optional<uint32_t>(it->second);
+    }
+
+    size_t size() const {
+        shared_lock<shared_mutex> lock(mu);
+        return strings.size();
+    }
+
+    // Rough footprint: the texts plus a deque slot and a hash node each.
+    size_t bytes() const {
+        shared_lock<shared_mutex> lock(mu);
+        return textBytes + strings.size() * (sizeof(string) + 48);
+    }
+};
+
+// ---------- Daily log table ----------
+// Logs are dense by day, so they live in 512-day chunks addressed by day number: a point
+// lookup is two array indexings and a date range is a scan over presence bits. Chunks
+// are allocated on first use and freed once empty; the directory spans only the chunks
+// between the first and last logged day.
+class LogTable {
+    static constexpr int kChunkBits = 9, kChunkDays = 1 << kChunkBits;
+    struct Chunk {
+        bitset<kChunkDays> present;
+        array<DailyLog, kChunkDays> logs{};
+    };
+    vector<unique_ptr<Chunk>> chunks; // chunks[i] holds chunk number firstChunk + i
+    int32_t firstChunk = 0;
+    size_t count = 0, allocated = 0;
+
+    static int32_t chunkOf(Date d) { return d.days >> kChunkBits; } // floors negative days too
+    static size_t offsetOf(Date d) { return size_t(d.days & (kChunkDays - 1)); }
+
+    Chunk *chunkAt(int32_t c) const {
+        int64_t i = int64_t(c) - firstChunk;
+        return i >= 0 && i < int64_t(chunks.size()) ? chunks[size_t(i)].get() : nullptr;
+    }
+
+    Chunk &makeChunk(Date d) {
+        int32_t c = chunkOf(d);
+        if (chunks.empty()) firstChunk = c;
+        else if (c < firstChunk) {
+            vector<unique_ptr<Chunk>> grown(size_t(firstChunk - c));
+            grown.insert(grown.end(), make_move_iterator(chunks.begin()), make_move_iterator(chunks.end()));
+            chunks.swap(grown);
+            firstChunk = c;
+        }
+        size_t i = size_t(c - firstChunk);
+        if (i >= chunks.size()) chunks.resize(i + 1);
+        if (!chunks[i]) { chunks[i] = make_unique<Chunk>(); ++allocated; }
+        return *chunks[i];
+    }
+
+public:
+    LogTable() = default;
+    LogTable(const LogTable &o) : firstChunk(o.firstChunk), count(o.count), allocated(o.allocated) {
+        chunks.reserve(o.chunks.size());
+        for (const auto &c : o.chunks) chunks.push_back(c ? make_unique<Chunk>(*c) : nullptr);
+    }
+    LogTable &operator=(const LogTable &) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t bytes() const { return chunks.capacity() * sizeof(chunks[0]) + allocated * sizeof(Chunk); }
+
+    // Chunk number of a day; tracker.snap indexes and pages logs by the same blocks.
+    static int32_t blockOf(Date d) { return chunkOf(d); }
+
+    DailyLog *find(Date d) {
+        Chunk *c = chunkAt(chunkOf(d));
+        return c && c->present[offsetOf(d)] ? &c->logs[offsetOf(d)] : nullptr;
+    }
+    const DailyLog *find(Date d) const { return const_cast<LogTable *>(this)->find(d); }
+
+    // Creates an empty log for the day if there is none.
+    DailyLog &operator[](Date d) {
+        Chunk &c = makeChunk(d);
+        size_t o = offsetOf(d);
+        if (!c.present[o]) { c.present.set(o); c.logs[o] = DailyLog{}; ++count; }
+        return c.logs[o];
+    }
+
+    bool erase(Date d) {
+        Chunk *c = chunkAt(chunkOf(d));
+        size_t o = offsetOf(d);
+        if (!c || !c->present[o]) return false;
+        c->present.reset(o);
+        --count;
+        if (c->present.none()) { chunks[size_t(chunkOf(d) - firstChunk)].reset(); --allocated; }
+        return true;
+    }
+
+    // Calls f(date, log) for every log in [from, to], in date order.
+    template <class F> void forEach(Date from, Date to, F &&f) const {
+        if (chunks.empty() || to < from) return;
+        int32_t first = max(chunkOf(from), firstChunk);
+        int32_t last = int32_t(min<int64_t>(chunkOf(to), int64_t(firstChunk) + int64_t(chunks.size()) - 1));
+        for (int32_t c = first; c <= last; ++c) {
+            const Chunk *ch = chunkAt(c);
+            if (!ch) continue;
+            size_t lo = c == chunkOf(from) ? offsetOf(from) : 0;
+            size_t hi = c == chunkOf(to) ? offsetOf(to) : kChunkDays - 1;
+            for (size_t o = lo ? ch->present._Find_next(lo - 1) : ch->present._Find_first(); o <= hi;
+                 o = ch->present._Find_next(o))
+                f(Date(int32_t(c * kChunkDays + int32_t(o))), ch->logs[o]);
+        }
+    }
+    template <class F> void forEach(F &&f) const { forEach(Date(INT32_MIN), Date(INT32_MAX), f); }
+
+    // Days covered by the chunk directory; every stored log lies inside. Only valid if !empty().
+    pair<Date, Date> span() const {
+        return {Date(firstChunk * kChunkDays), Date(int32_t((int64_t(firstChunk) + int64_t(chunks.size())) * kChunkDays - 1))};
+    }
+};
+
+// ---------- Log search index ----------
+// Inverted index from symptom / mood token to the sorted days it was logged on. Texts
+// are split on ';' and ',' and lower-cased, so "Cramps; headache" indexes "cramps" and
+// "headache". Tokens are pooled too, and the split is cached per pooled text.
+enum class LogField : uint8_t { Symptom, Mood };
+
+class LogIndex {
+    StringPool &pool; // the owning tracker's
+    unordered_map<uint64_t, vector<int32_t>> postings;   // (field, token id) -> days
+    unordered_map<uint32_t, vector<uint32_t>> tokenCache; // text id -> its token ids
+
+    static uint64_t key(LogField f, uint32_t token) { return uint64_t(f) << 32 | token; }
+
+    const vector<uint32_t> &tokensOf(uint32_t text) {
+        auto res = tokenCache.try_emplace(text);
+        vector<uint32_t> &toks = res.first->second;
+        if (!res.second) return toks;
+        string_view rest = pool.str(text);
+        while (!rest.empty()) {
+            size_t sep = rest.find_first_of(";,");
+            string t = normalize(rest.substr(0, sep));
+            if (!t.empty()) toks.push_back(pool.intern(t));
+            rest = sep == string_view::npos ? string_view() : rest.substr(sep + 1);
+        }
+        sort(toks.begin(), toks.end());
+        toks.erase(unique(toks.begin(), toks.end()), toks.end());
+        return toks;
+    }
+
+    void update(LogField f, uint32_t text, int32_t day, bool add) {
+        if (text == 0) return;
+        for (uint32_t tok : tokensOf(text)) {
+            vector<int32_t> &days = postings[key(f, tok)];
+            if (add) {
+                if (days.empty() || days.back() < day) days.push_back(day); // the common, in-order case
+                else if (auto it = lower_bound(days.begin(), days.end(), day); *it != day) days.insert(it, day);
+            } else {
+                auto it = lower_bound(days.begin(), days.end(), day);
+                if (it != days.end() && *it == day) days.erase(it);
+                if (days.empty()) postings.erase(key(f, tok));
+            }
+        }
+    }
+
+public:
+    explicit LogIndex(StringPool &textPool) : pool(textPool) {}
+
+    static string normalize(string_view token) {
+        string t(trim(token));
+        for (char &c : t) c = char(tolower((unsigned char)c));
+        return t;
+    }
+
+    void add(Date d, const DailyLog &l) {
+        update(LogField::Symptom, l.symptoms, d.days, true);
+        update(LogField::Mood, l.mood, d.days, true);
+    }
+    void remove(Date d, const DailyLog &l) {
+        update(LogField::Symptom, l.symptoms, d.days, false);
+        update(LogField::Mood, l.mood, d.days, false);
+    }
+
+    // Sorted days logged with `token`; null if it never was.
+    const vector<int32_t> *find(LogField f, string_view token) const {
+        auto id = pool.lookup(normalize(token));
+        if (!id) return nullptr;
+        auto it = postings.find(key(f, *id));
+        return it == postings.end() ? nullptr : &it->second;
+    }
+};
+
+enum class CyclePhase { Any, Menstrual, Follicular, Ovulatory, Luteal };
+
+// All terms must match. Phases and cycle days are relative to the cycle a day falls in;
+// days before the first cycle or past the predicted next start match neither.
+struct LogQuery {
+    vector<pair<LogField, string>> terms;
+    Date from = Date(INT32_MIN), to = Date(INT32_MAX);
+    CyclePhase phase = CyclePhase::Any;
+    int cycleDayFrom = 0, cycleDayTo = 0; // 1-based, 0 = unbounded
+};
+
+// Query syntax: space-separated terms
+//   WORD or sym:WORD   symptom token          mood:WORD        mood token
+//   from:DATE to:DATE  date range             phase:NAME       menstrual/follicular/ovulatory/luteal
+//   day:N or day:N-M   day N (to M) of the cycle
+static bool parseLogQuery(string_view text, LogQuery &q, string &err) {
+    static const pair<string_view, CyclePhase> phases[] = {{"menstrual", CyclePhase::Menstrual},
+        {"follicular", CyclePhase::Follicular}, {"ovulatory", CyclePhase::Ovulatory}, {"luteal", CyclePhase::Luteal}};
+    string_view rest = trim(text);
+    while (!rest.empty()) {
+        string_view w = nextWord(rest);
+        size_t colon = w.find(':');
+        string_view name = colon == string_view::npos ? "sym" : w.substr(0, colon);
+        string_view value = colon == string_view::npos ? w : w.substr(colon + 1);
+        bool ok = !value.empty();
+        if (name == "sym" || name == "mood") q.terms.emplace_back(name == "sym" ? LogField::Symptom : LogField::Mood, string(value));
+        else if (name == "from") ok = parseDate(value, q.from);
+        else if (name == "to") ok = parseDate(value, q.to);
+        else if (name == "phase") {
+            auto it = find_if(begin(phases), end(phases), [&](const auto &p) { return p.first == value; });
+            if ((ok = it != end(phases))) q.phase = it->second;
+        } else if (name == "day") {
+            size_t dash = value.find('-');
+            ok = parseInt(value.substr(0, dash), q.cycleDayFrom) && q.cycleDayFrom > 0;
+            q.cycleDayTo = q.cycleDayFrom;
+            if (ok && dash != string_view::npos) ok = parseInt(value.substr(dash + 1), q.cycleDayTo) && q.cycleDayTo >= q.cycleDayFrom;
+        } else ok = false;
+        if (!ok) { err = "bad query term '" + string(w) + "'"; return false; }
+    }
+    return true;
+}
+
+// ---------- Output sink ----------
+// Listings are formatted into one reusable per-thread buffer with to_chars / memcpy and
+// handed to the stream in large blocks, rather than through << and setw per field.
+// Cells are left-aligned and padded like setw (never truncated). With a page size set,
+// the sink stops every pageRows rows and asks before going on.
+class OutSink {
+    static constexpr size_t kFlushBytes = 1 << 16;
+    ostream &os;
+    string &buf;
+    size_t pageRows, rowsOnPage = 0;
+    bool stopped = false;
+
+    static string &scratch() { thread_local string s; return s; }
+
+    // Reads the answer from cin; a newline left behind by an earlier `cin >>` is skipped.
+    bool askForMore() {
+        flush();
+        os << "-- more (Enter: next page, q: stop) -- " << std::flush;
+        if (cin.rdbuf()->in_avail() > 0 && cin.peek() == '\n') cin.get();
+        string answer;
+        return getline(cin, answer) && (answer.empty() || (answer[0] != 'q' && answer[0] != 'Q'));
+    }
+
+public:
+    explicit OutSink(ostream &out, size_t pageRows = 0) : os(out), buf(scratch()), pageRows(pageRows) {
+        buf.clear();
+        buf.reserve(kFlushBytes + 1024);
+    }
+    ~OutSink() { flush(); }
+    OutSink(const OutSink &) = delete;
+    OutSink &operator=(const OutSink &) = delete;
+
+    // True once the reader declined the next page; later rows are dropped.
+    bool done() const { return stopped; }
+
+    OutSink &text(string_view s) { if (!stopped) buf.append(s); return *this; }
+    OutSink &num(long long v) {
+        char t[24];
+        return text(string_view(t, size_t(to_chars(t, t + sizeof t, v).ptr - t)));
+    }
+    OutSink &cell(string_view s, size_t width) {
+        text(s);
+        if (!stopped && s.size() < width) buf.append(width - s.size(), ' ');
+        return *this;
+    }
+    OutSink &cell(long long v, size_t width) {
+        char t[24];
+        return cell(string_view(t, size_t(to_chars(t, t + sizeof t, v).ptr - t)), width);
+    }
+    OutSink &cell(Date d, size_t width) {
+        char t[16];
+        return cell(string_view(t, size_t(formatDate(d, t) - t)), width);
+    }
+
+    void endRow() {
+        if (stopped) return;
+        buf += '\n';
+        if (pageRows && ++rowsOnPage == pageRows) { rowsOnPage = 0; stopped = !askForMore(); }
+        else if (buf.size() >= kFlushBytes) flush();
+    }
+
+    void flush() {
+        if (buf.empty()) return;
+        os.write(buf.data(), streamsize(buf.size()));
+        buf.clear();
+    }
+};
+
+// Rows that fit the terminal below a header, or 0 (no paging) when not interactive.
+static size_t terminalPageRows() {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) return 0;
+    winsize ws{};
+    size_t rows = ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 ? ws.ws_row : 24;
+    return rows > 8 ? rows - 2 : 0;
+}
+
+// ---------- Metrics ----------
+// Per-site call counts and latency histograms, fed by PT_TIMED("name") scoped timers.
+// Each site owns a function-local Metric registered on first use; recording is two clock
+// reads and a few relaxed atomic adds. Bucket i counts calls of at most 256 ns * 2^i (the
+// last one everything slower). Define PT_NO_METRICS to compile all of it out.
+#ifndef PT_NO_METRICS
+struct Metric {
+    static constexpr int kBuckets = 24;
+    const char *const name;
+    atomic<uint64_t> totalNs{0}, maxNs{0};
+    array<atomic<uint64_t>, kBuckets> buckets{};
+
+    explicit Metric(const char *n);
+
+    static uint64_t bucketLimitNs(int i) { return uint64_t(256) << i; }
+
+    // The call count is the bucket total, which saves an atomic add per call.
+    uint64_t count() const {
+        uint64_t n = 0;
+        for (const auto &b : buckets) n += b.load(memory_order_relaxed);
+        return n;
+    }
+
+    void record(uint64_t ns) {
+        totalNs.fetch_add(ns, memory_order_relaxed);
+        for (uint64_t m = maxNs.load(memory_order_relaxed); ns > m && !maxNs.compare_exchange_weak(m, ns, memory_order_relaxed);) {}
+        int b = ns <= 256 ? 0 : min(kBuckets - 1, 64 - __builtin_clzll((ns - 1) >> 8));
+        buckets[size_t(b)].fetch_add(1, memory_order_relaxed);
+    }
+};
+
+class MetricRegistry {
+    mutable mutex mu;
+    vector<const Metric *> metrics;
+
+public:
+    static MetricRegistry &global() { static MetricRegistry r; return r; }
+
+    void add(const Metric *m) {
+        lock_guard<mutex> g(mu);
+        metrics.push_back(m);
+    }
+
+    void writeJson(ostream &os) const {
+        lock_guard<mutex> g(mu);
+        os << "{\"metrics\":[";
+        for (size_t i = 0; i < metrics.size(); ++i) {
+            const Metric &m = *metrics[i];
+            uint64_t n = m.count(), total = m.totalNs.load(memory_order_relaxed);
+            os << (i ? "," : "") << "{\"name\":\"" << m.name << "\",\"count\":" << n << ",\"total_ns\":" << total
+               << ",\"mean_ns\":" << (n ? total / n : 0) << ",\"max_ns\":" << m.maxNs.load(memory_order_relaxed) << ",\"buckets\":[";
+            bool first = true;
+            for (int b = 0; b < Metric::kBuckets; ++b) {
+                uint64_t c = m.buckets[size_t(b)].load(memory_order_relaxed);
+                if (!c) continue;
+                os << (first ? "" : ",") << "{\"le_ns\":";
+                if (b == Metric::kBuckets - 1) os << "null"; else os << Metric::bucketLimitNs(b);
+                os << ",\"count\":" << c << "}";
+                first = false;
+            }
+            os << "]}";
+        }
+        os << "]}\n";
+    }
+
+    // Prometheus text exposition format; buckets are cumulative, bounds in seconds.
+    void writePrometheus(ostream &os) const {
+        lock_guard<mutex> g(mu);
+        os << "# HELP pt_op_duration_seconds Latency of tracker operations.\n"
+           << "# TYPE pt_op_duration_seconds histogram\n";
+        for (const Metric *m : metrics) {
+            uint64_t cumulative = 0;
+            for (int b = 0; b < Metric::kBuckets; ++b) {
+                cumulative += m->buckets[size_t(b)].load(memory_order_relaxed);
+                os << "pt_op_duration_seconds_bucket{op=\"" << m->name << "\",le=\"";
+                if (b == Metric::kBuckets - 1) os << "+Inf"; else os << double(Metric::bucketLimitNs(b)) * 1e-9;
+                os << "\"} " << cumulative << "\n";
+            }
+            os << "pt_op_duration_seconds_sum{op=\"" << m->name << "\"} " << double(m->totalNs.load(memory_order_relaxed)) * 1e-9 << "\n"
+               << "pt_op_duration_seconds_count{op=\"" << m->name << "\"} " << m->count() << "\n";
+        }
+    }
+};
+
+inline Metric::Metric(const char *n) : name(n) { MetricRegistry::global().add(this); }
+
+class ScopedTimer {
+    Metric &metric;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+public:
+    explicit ScopedTimer(Metric &m) : metric(m) {}
+    ~ScopedTimer() { metric.record(uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count())); }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+#define PT_CONCAT_(a, b) a##b
+#define PT_CONCAT(a, b) PT_CONCAT_(a, b)
+#define PT_TIMED(name)                                  \
+    static Metric PT_CONCAT(ptMetric_, __LINE__)(name); \
+    ScopedTimer PT_CONCAT(ptTimer_, __LINE__)(PT_CONCAT(ptMetric_, __LINE__))
+#else
+#define PT_TIMED(name) ((void)0)
+#endif
+
+// Writes every metric as "json" or "prometheus"; false for an unknown format.
+static bool writeMetrics(ostream &os, string_view format) {
+    bool json = format == "json";
+    if (!json && format != "prometheus") return false;
+#ifndef PT_NO_METRICS
+    if (json) MetricRegistry::global().writeJson(os);
+    else MetricRegistry::global().writePrometheus(os);
+#else
+    os << (json ? "{\"metrics\":[]}\n" : "# metrics disabled (PT_NO_METRICS)\n");
+#endif
+    return true;
+}
+
+// ---------- Streaming CSV reader ----------
+// Reads the file in large chunks and splits each row into trimmed string_view fields.
+// Nothing is allocated per row; the views stay valid until the next call to next().
+class CsvReader {
+    FILE *fp = nullptr;
+    vector<char> buf;
+    size_t pos = 0, len = 0;
+    size_t line = 0;
+    bool eof = false;
+
+    bool nextLine(string_view &out) {
+        if (!fp) return false;
+        for (;;) {
+            const char *base = buf.data() + pos;
+            const char *nl = pos < len ? static_cast<const char *>(memchr(base, '\n', len - pos)) : nullptr;
+            if (nl) {
+                out = string_view(base, size_t(nl - base));
+                pos += out.size() + 1;
+                return true;
+            }
+            if (eof) {
+                if (pos == len) return false;
+                out = string_view(base, len - pos);
+                pos = len;
+                return true;
+            }
+            memmove(buf.data(), base, len - pos);
+            len -= pos; pos = 0;
+            if (len == buf.size()) buf.resize(buf.size() * 2); // single row longer than the buffer
+            size_t got = fread(buf.data() + len, 1, buf.size() - len, fp);
+            if (got == 0) eof = true;
+            len += got;
+        }
+    }
+
+public:
+    explicit CsvReader(const string &path, size_t chunkSize = 1 << 16)
+        : fp(fopen(path.c_str(), "rb")), buf(chunkSize) {}
+    ~CsvReader() { if (fp) fclose(fp); }
+    CsvReader(const CsvReader &) = delete;
+    CsvReader &operator=(const CsvReader &) = delete;
+
+    bool isOpen() const { return fp != nullptr; }
+    size_t lineNumber() const { return line; }
+
+    // Returns false at end of file; blank lines are skipped.
+    bool next(vector<string_view> &fields) {
+        string_view row;
+        while (nextLine(row)) {
+            ++line;
+            row = trim(row);
+            if (row.empty()) continue;
+            fields.clear();
+            for (size_t b = 0;;) {
+                size_t c = row.find(',', b);
+                fields.push_back(trim(row.substr(b, c == string_view::npos ? string_view::npos : c - b)));
+                if (c == string_view::npos) break;
+                b = c + 1;
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+static void reportBadRow(const string &file, size_t line, const char *why) {
+    cerr << YELLOW << "⚠️  " << file << ":" << line << ": " << why << " (row skipped)" << RESET << "\n";
+}
+
+// ---------- Reminder store ----------
+// Reminders kept in a flat vector sorted by (day, id). The next K reminders are a
+// contiguous slice that can be walked without copying; expired ones are dropped as a
+// single prefix erase, and individual reminders are removed by id.
+class ReminderStore {
+    vector<Reminder> items;
+    unordered_map<uint32_t, Date> whenById;
+
+    static bool before(const Reminder &r, pair<Date, uint32_t> key) {
+        return r.when < key.first || (r.when == key.first && r.id < key.second);
+    }
+
+public:
+    struct Range {
+        const Reminder *first, *last;
+        const Reminder *begin() const { return first; }
+        const Reminder *end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    void clear() { items.clear(); whenById.clear(); }
+
+    // Ids are assigned by the owner so they stay unique across several stores.
+    void add(uint32_t id, Date when, string message) {
+        auto pos = lower_bound(items.begin(), items.end(), make_pair(when, id), before);
+        items.insert(pos, Reminder{when, id, move(message)});
+        whenById.emplace(id, when);
+    }
+
+    bool contains(uint32_t id) const { return whenById.count(id) > 0; }
+
+    bool remove(uint32_t id) {
+        auto w = whenById.find(id);
+        if (w == whenById.end()) return false;
+        auto pos = lower_bound(items.begin(), items.end(), make_pair(w->second, id), before);
+        items.erase(pos);
+        whenById.erase(w);
+        return true;
+    }
+
+    // Removes every reminder dated before `day`.
+    void dropBefore(Date day) {
+        auto pos = lower_bound(items.begin(), items.end(), make_pair(day, uint32_t(0)), before);
+        for (auto it = items.begin(); it != pos; ++it) whenById.erase(it->id);
+        items.erase(items.begin(), pos);
+    }
+
+    Range upcoming(size_t k) const {
+        const Reminder *b = items.data();
+        return {b, b + min(k, items.size())};
+    }
+};
+
+// ---------- Column kernels ----------
+// Sum/min/max/count over an int32 column, restricted to rows whose mask is -1 (and,
+// optionally, whose value is > 0). The AVX2 version is picked at runtime when the CPU
+// supports it; the scalar loop is the reference and handles the tail.
+struct ColumnStats {
+    int64_t sum = 0;
+    int32_t min = INT32_MAX, max = INT32_MIN;
+    size_t count = 0;
+};
+
+static ColumnStats columnStatsScalar(const int32_t *v, const int32_t *mask, size_t n, bool positiveOnly, ColumnStats r = {}) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!mask[i] || (positiveOnly && v[i] <= 0)) continue;
+        r.sum += v[i]; r.min = min(r.min, v[i]); r.max = max(r.max, v[i]); ++r.count;
+    }
+    return r;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target("avx2")))
+static ColumnStats columnStatsAvx2(const int32_t *v, const int32_t *mask, size_t n, bool positiveOnly) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero, cnt = zero;
+    __m256i mn = _mm256_set1_epi32(INT32_MAX), mx = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+        __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+        if (positiveOnly) m = _mm256_and_si256(m, _mm256_cmpgt_epi32(x, zero));
+        __m256i sel = _mm256_and_si256(x, m);
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(sel)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(sel, 1)));
+        mn = _mm256_min_epi32(mn, _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MAX), x, m));
+        mx = _mm256_max_epi32(mx, _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MIN), x, m));
+        cnt = _mm256_sub_epi32(cnt, m);
+    }
+    alignas(32) int64_t s64[4];
+    alignas(32) int32_t mn32[8], mx32[8], c32[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(s64), sum);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mn32), mn);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mx32), mx);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(c32), cnt);
+    ColumnStats r;
+    for (int k = 0; k < 4; ++k) r.sum += s64[k];
+    for (int k = 0; k < 8; ++k) { r.min = min(r.min, mn32[k]); r.max = max(r.max, mx32[k]); r.count += uint32_t(c32[k]); }
+    return columnStatsScalar(v + i, mask + i, n - i, positiveOnly, r);
+}
+#endif
+
+static ColumnStats columnStats(const int32_t *v, const int32_t *mask, size_t n, bool positiveOnly) {
+#if defined(__GNUC__) && defined(__x86_64__)
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) return columnStatsAvx2(v, mask, n, positiveOnly);
+#endif
+    return columnStatsScalar(v, mask, n, positiveOnly);
+}
+
+// ---------- Cycle store ----------
+// Cycles are stored column-wise (contiguous int32 start/end/duration/length arrays plus
+// a live mask) with an ordered index from start day to row, so lookup/insert/delete are
+// O(log n), iteration runs in start-date order and whole-column scans stay cache-dense.
+// Deleting clears the row's mask; rows are compacted once dead ones outnumber live ones.
+class CycleStore {
+    using Index = map<int32_t, uint32_t>;
+    struct Columns {
+        vector<int32_t> start, end, duration, length, live; // live: -1 = row in use, 0 = tombstone
+        size_t size() const { return start.size(); }
+        void push(const CycleEntry &c) {
+            start.push_back(c.startDate.days); end.push_back(c.endDate.days);
+            duration.push_back(c.durationDays); length.push_back(c.cycleLength); live.push_back(-1);
+        }
+        CycleEntry row(uint32_t r) const { return CycleEntry(Date(start[r]), Date(end[r]), duration[r], length[r]); }
+    };
+    Columns cols;
+    Index byStart;
+    size_t dead = 0;
+
+    void compact() {
+        Columns packed;
+        for (auto &p : byStart) { packed.push(cols.row(p.second)); p.second = uint32_t(packed.size() - 1); }
+        cols = move(packed);
+        dead = 0;
+    }
+
+public:
+    class const_iterator {
+        Index::const_iterator it;
+        const Columns *cols = nullptr;
+    public:
+        const_iterator(Index::const_iterator i, const Columns *c) : it(i), cols(c) {}
+        CycleEntry operator*() const { return cols->row(it->second); }
+        const_iterator &operator++() { ++it; return *this; }
+        const_iterator &operator--() { --it; return *this; }
+        bool operator==(const const_iterator &o) const { return it == o.it; }
+        bool operator!=(const const_iterator &o) const { return it != o.it; }
+    };
+
+    const_iterator begin() const { return {byStart.begin(), &cols}; }
+    const_iterator end() const { return {byStart.end(), &cols}; }
+    const_iterator lowerBound(Date start) const { return {byStart.lower_bound(start.days), &cols}; }
+    size_t size() const { return byStart.size(); }
+    bool empty() const { return byStart.empty(); }
+    CycleEntry back() const { return cols.row(byStart.rbegin()->second); }
+
+    optional<CycleEntry> find(Date start) const {
+        auto it = byStart.find(start.days);
+        if (it == byStart.end()) return nullopt;
+        return cols.row(it->second);
+    }
+
+    // Nearest stored cycle strictly before / after the given start day.
+    optional<CycleEntry> before(Date start) const {
+        auto it = byStart.lower_bound(start.days);
+        if (it == byStart.begin()) return nullopt;
+        return cols.row(prev(it)->second);
+    }
+
+    optional<CycleEntry> after(Date start) const {
+        auto it = byStart.upper_bound(start.days);
+        if (it == byStart.end()) return nullopt;
+        return cols.row(it->second);
+    }
+
+    void setCycleLength(Date start, int len) {
+        auto it = byStart.find(start.days);
+        if (it != byStart.end()) cols.length[it->second] = len;
+    }
+
+    // Fails (returns false) if a cycle with the same start day is already stored.
+    bool insert(const CycleEntry &c) {
+        auto res = byStart.emplace(c.startDate.days, uint32_t(cols.size()));
+        if (!res.second) return false;
+        cols.push(c);
+        return true;
+    }
+
+    bool erase(Date start) {
+        auto it = byStart.find(start.days);
+        if (it == byStart.end()) return false;
+        cols.live[it->second] = 0;
+        byStart.erase(it);
+        if (++dead > 64 && dead > byStart.size()) compact();
+        return true;
+    }
+
+    // Whole-column scans over live rows (row order, not start order).
+    ColumnStats lengthStats() const { return columnStats(cols.length.data(), cols.live.data(), cols.size(), true); }
+
+    template <class F> void forEachRow(F f) const {
+        for (size_t r = 0; r < cols.size(); ++r)
+            if (cols.live[r]) f(cols.duration[r], cols.length[r]);
+    }
+};
+
+// ---------- Running statistics ----------
+// Count, sum and sum of squares, plus the values split into a lower and an upper half
+// (two multisets) so min/max/median read in O(1) and add/remove cost O(log n).
+class RunningStats {
+    long long total = 0, totalSq = 0;
+    multiset<int> lo, hi; // all of lo <= all of hi; lo holds the extra element when odd
+
+    void rebalance() {
+        if (lo.size() > hi.size() + 1) { hi.insert(*prev(lo.end())); lo.erase(prev(lo.end())); }
+        else if (hi.size() > lo.size()) { lo.insert(*hi.begin()); hi.erase(hi.begin()); }
+    }
+
+public:
+    void add(int v) {
+        total += v; totalSq += 1LL * v * v;
+        if (lo.empty() || v <= *lo.rbegin()) lo.insert(v); else hi.insert(v);
+        rebalance();
+    }
+
+    bool remove(int v) {
+        auto it = lo.find(v);
+        if (it != lo.end()) lo.erase(it);
+        else if ((it = hi.find(v)) != hi.end()) hi.erase(it);
+        else return false;
+        total -= v; totalSq -= 1LL * v * v;
+        rebalance();
+        return true;
+    }
+
+    size_t count() const { return lo.size() + hi.size(); }
+    long long sum() const { return total; }
+    // The accessors below require count() > 0.
+    double mean() const { return double(total) / count(); }
+    double variance() const { double m = mean(); return std::max(0.0, double(totalSq) / count() - m * m); }
+    double stddev() const { return sqrt(variance()); }
+    int min() const { return *lo.begin(); }
+    int max() const { return hi.empty() ? *lo.rbegin() : *hi.rbegin(); }
+    double median() const { return lo.size() > hi.size() ? *lo.rbegin() : (*lo.rbegin() + *hi.begin()) / 2.0; }
+};
+
+// ---------- Windowed statistics ----------
+// Robust statistics over a sliding window of cycle lengths. Two Fenwick trees over the
+// length values hold the count and the sum of each value in the window, so an update is
+// O(log V) and the rank queries behind the median, trimmed mean and MAD are O(log V) or
+// O(log^2 V), with V = kValues and nothing sorted. Lengths of kValues or more (gaps of
+// nearly three years) are counted as kValues - 1.
+class WindowedStats {
+public:
+    static constexpr int kValues = 1024;          // power of two, for the rank descent
+    static constexpr size_t kMaxWindow = 1000;     // keeps counts in 16 bits and sums in 32
+
+private:
+    array<uint16_t, kValues + 1> counts{};         // 1-based: value v lives at v + 1
+    array<uint32_t, kValues + 1> sums{};
+    size_t n = 0;
+
+    static int clampValue(int v) { return std::clamp(v, 0, kValues - 1); }
+
+    void update(int v, int dc) {
+        v = clampValue(v);
+        for (int i = v + 1; i <= kValues; i += i & -i) { counts[size_t(i)] = uint16_t(counts[size_t(i)] + dc); sums[size_t(i)] += uint32_t(dc * v); }
+    }
+
+    // Values <= v.
+    size_t countUpTo(int v) const {
+        if (v < 0) return 0;
+        size_t c = 0;
+        for (int i = clampValue(v) + 1; i > 0; i -= i & -i) c += counts[size_t(i)];
+        return c;
+    }
+
+    // Sum of the k smallest values.
+    long long sumSmallest(size_t k) const {
+        if (k == 0) return 0;
+        int pos = 0;
+        size_t c = 0;
+        long long total = 0;
+        for (int step = kValues; step > 0; step >>= 1)
+            if (pos + step <= kValues && c + counts[size_t(pos + step)] < k) { pos += step; c += counts[size_t(pos)]; total += sums[size_t(pos)]; }
+        return total + (long long)(k - c) * pos; // the rest are copies of value `pos`
+    }
+
+    // Half-day units: the k-th smallest |2x - m2| (1-based), by bisection on countWithin.
+    int kthDeviation(size_t k, int m2) const {
+        int lo = 0, hi = 2 * kValues;
+        while (lo < hi) {
+            int d = (lo + hi) / 2;
+            size_t within = countUpTo((m2 + d) >> 1) - countUpTo(((m2 - d + 1) >> 1) - 1); // ceil((m2 - d) / 2)
+            if (within >= k) hi = d; else lo = d + 1;
+        }
+        return lo;
+    }
+
+public:
+    void add(int v) { update(v, 1); ++n; }
+    void remove(int v) { update(v, -1); --n; }
+
+    size_t count() const { return n; }
+    // The accessors below require count() > 0.
+    // k-th smallest value, 1-based.
+    int kth(size_t k) const {
+        int pos = 0;
+        size_t c = 0;
+        for (int step = kValues; step > 0; step >>= 1)
+            if (pos + step <= kValues && c + counts[size_t(pos + step)] < k) { pos += step; c += counts[size_t(pos)]; }
+        return pos; // index pos + 1 holds the value pos
+    }
+    int min() const { return kth(1); }
+    int max() const { return kth(n); }
+    double median() const { return n % 2 ? kth(n / 2 + 1) : (kth(n / 2) + kth(n / 2 + 1)) / 2.0; }
+    // Values within [lo, hi].
+    size_t countBetween(double lo, double hi) const {
+        int a = int(ceil(lo)), b = int(floor(hi));
+        return a > b ? 0 : countUpTo(b) - countUpTo(a - 1);
+    }
+
+    // Mean after dropping `fraction` of the values at each end.
+    double trimmedMean(double fraction = 0.2) const {
+        size_t cut = size_t(double(n) * fraction);
+        return double(sumSmallest(n - cut) - sumSmallest(cut)) / double(n - 2 * cut);
+    }
+    // Range of the values left after the same trimming.
+    int trimmedRange(double fraction = 0.2) const {
+        size_t cut = size_t(double(n) * fraction);
+        return kth(n - cut) - kth(cut + 1);
+    }
+
+    // Median absolute deviation from the median.
+    double mad() const {
+        int m2 = int(lround(2 * median()));
+        if (n % 2) return kthDeviation(n / 2 + 1, m2) / 2.0;
+        return (kthDeviation(n / 2, m2) + kthDeviation(n / 2 + 1, m2)) / 4.0;
+    }
+};
+
+// ---------- CSV / journal writers ----------
+static void putDate(FILE *fp, Date d) {
+    char buf[10];
+    fwrite(buf, 1, size_t(formatDate(d, buf) - buf), fp);
+}
+
+static void putInt(FILE *fp, int v) {
+    char buf[16];
+    fwrite(buf, 1, size_t(to_chars(buf, buf + sizeof buf, v).ptr - buf), fp);
+}
+
+// Writes a text field with commas turned into ';' so it cannot split the row; no copy made.
+static void putField(FILE *fp, string_view s) {
+    for (size_t c; (c = s.find(',')) != string_view::npos; s.remove_prefix(c + 1)) {
+        fwrite(s.data(), 1, c, fp);
+        fputc(';', fp);
+    }
+    fwrite(s.data(), 1, s.size(), fp);
+}
+
+static void writeCycleRow(FILE *fp, const CycleEntry &c) {
+    putDate(fp, c.startDate); fputc(',', fp);
+    putDate(fp, c.endDate); fputc(',', fp);
+    putInt(fp, c.durationDays); fputc(',', fp);
+    putInt(fp, c.cycleLength); fputc('\n', fp);
+}
+
+static void writeLogRow(FILE *fp, Date d, string_view symptoms, string_view mood) {
+    putDate(fp, d); fputc(',', fp);
+    putField(fp, symptoms); fputc(',', fp);
+    putField(fp, mood); fputc('\n', fp);
+}
+
+static void writeLogRow(FILE *fp, Date d, const DailyLog &l, const StringPool &pool) {
+    writeLogRow(fp, d, pool.str(l.symptoms), pool.str(l.mood));
+}
+
+// ---------- Write-ahead journal ----------
+// One record per mutation, flushed as it is written (unless batching) so a crash loses
+// at most that record:
+//   +,start,end,duration,cycleLength   cycle added
+//   -,start,end                        cycle removed
+//   L,date,symptoms,mood               daily log set to this value
+//   X,date                             daily log removed (undo of a first entry)
+// Replaying is idempotent, so a journal may safely be applied on top of a snapshot
+// that already contains some of its records.
+// The background saver folds it into a fresh snapshot a little after edits stop.
+class Journal {
+    const StringPool &pool; // resolves log text ids
+    FILE *fp = nullptr;
+    bool autoFlush = true;
+
+    void endRecord() { if (autoFlush) fflush(fp); }
+
+public:
+    explicit Journal(const StringPool &textPool) : pool(textPool) {}
+    ~Journal() { close(); }
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    bool open(const string &path) { close(); fp = fopen(path.c_str(), "ab"); return fp != nullptr; }
+    void close() { if (fp) fclose(fp); fp = nullptr; }
+    void setAutoFlush(bool on) { autoFlush = on; if (on) flush(); }
+    bool autoFlushing() const { return autoFlush; }
+    void flush() { if (fp) fflush(fp); }
+
+    void cycleAdded(const CycleEntry &c) {
+        if (!fp) return;
+        fputs("+,", fp); writeCycleRow(fp, c); endRecord();
+    }
+    void cycleRemoved(const CycleEntry &c) {
+        if (!fp) return;
+        fputs("-,", fp); putDate(fp, c.startDate); fputc(',', fp); putDate(fp, c.endDate); fputc('\n', fp); endRecord();
+    }
+    void logSet(Date d, const DailyLog &l) {
+        if (!fp) return;
+        fputs("L,", fp); writeLogRow(fp, d, l, pool); endRecord();
+    }
+    void logRemoved(Date d) {
+        if (!fp) return;
+        fputs("X,", fp); putDate(fp, d); fputc('\n', fp); endRecord();
+    }
+};
+
+static bool fileHasData(const string &path) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    bool has = fgetc(fp) != EOF;
+    fclose(fp);
+    return has;
+}
+
+static bool appendFile(const string &from, const string &to) {
+    FILE *in = fopen(from.c_str(), "rb");
+    if (!in) return false;
+    FILE *out = fopen(to.c_str(), "ab");
+    if (!out) { fclose(in); return false; }
+    char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, in)) > 0) fwrite(buf, 1, n, out);
+    fclose(in);
+    return fclose(out) == 0;
+}
+
+// ---------- Streaming import / export ----------
+// Interchange files hold cycles and logs merged in date order, one record per line:
+//   csv:     cycle,START,END,DURATION,CYCLE_LEN      log,DATE,SYMPTOMS,MOOD
+//   ndjson:  {"type":"cycle","start":"...","end":"...","duration":N,"cycleLength":N}
+//            {"type":"log","date":"...","symptoms":"...","mood":"..."}
+// Imports also take untagged cycles.csv (4-field) and daily_logs.csv (3-field) rows;
+// duration and cycle length are always recomputed, never trusted from the file.
+enum class StreamFormat { Csv, Ndjson };
+
+// Explicit name ("csv" / "ndjson") if given, else from the extension; false if neither fits.
+static bool streamFormatFor(string_view path, string_view name, StreamFormat &out) {
+    if (name.empty()) {
+        size_t dot = path.rfind('.');
+        name = dot == string_view::npos ? string_view() : path.substr(dot + 1);
+        if (name == "jsonl") name = "ndjson";
+    }
+    if (name == "csv") out = StreamFormat::Csv;
+    else if (name == "ndjson") out = StreamFormat::Ndjson;
+    else return false;
+    return true;
+}
+
+// Fixed-capacity hand-off between pipeline stages: push blocks while full, pop while
+// empty. After close() pushes are refused and pops drain what is left, then fail.
+template <class T>
+class BoundedQueue {
+    mutex mu;
+    condition_variable notFull, notEmpty;
+    deque<T> items;
+    const size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BoundedQueue(size_t cap) : capacity(cap) {}
+
+    bool push(T v) {
+        unique_lock<mutex> lock(mu);
+        notFull.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(move(v));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    optional<T> pop() {
+        unique_lock<mutex> lock(mu);
+        notEmpty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) return nullopt;
+        optional<T> v(move(items.front()));
+        items.pop_front();
+        notFull.notify_one();
+        return v;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(mu);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+// One parsed line: fields are (offset, length) into the owning chunk's text, so chunks
+// can move between threads without fixing up pointers. Cycles use f[0..1] (start, end),
+// logs f[0..2] (date, symptoms, mood).
+struct ImportRow {
+    size_t line = 0;
+    bool cycle = false;
+    const char *error = nullptr;
+    uint32_t off[3] = {}, len[3] = {};
+};
+
+struct ImportChunk {
+    string text;
+    vector<ImportRow> rows;
+    string_view field(const ImportRow &r, int i) const { return string_view(text.data() + r.off[i], r.len[i]); }
+};
+
+// Validated record ready to merge; the log text is already interned.
+struct ImportRecord {
+    bool cycle;
+    Date first, second; // cycle start / end, or the log date
+    DailyLog log;
+};
+
+struct ImportResult {
+    size_t cycles = 0, logs = 0, duplicates = 0, rejected = 0;
+};
+
+// Appends code point cp as UTF-8 at w.
+static char *putUtf8(char *w, uint32_t cp) {
+    if (cp < 0x80) *w++ = char(cp);
+    else if (cp < 0x800) { *w++ = char(0xC0 | cp >> 6); *w++ = char(0x80 | (cp & 0x3F)); }
+    else if (cp < 0x10000) { *w++ = char(0xE0 | cp >> 12); *w++ = char(0x80 | (cp >> 6 & 0x3F)); *w++ = char(0x80 | (cp & 0x3F)); }
+    else {
+        *w++ = char(0xF0 | cp >> 18); *w++ = char(0x80 | (cp >> 12 & 0x3F));
+        *w++ = char(0x80 | (cp >> 6 & 0x3F)); *w++ = char(0x80 | (cp & 0x3F));
+    }
+    return w;
+}
+
+static bool hex4(const char *p, const char *end, uint32_t &v) {
+    if (end - p < 4) return false;
+    v = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (d < 0) return false;
+        v = v << 4 | uint32_t(d);
+    }
+    return true;
+}
+
+// Parses a flat JSON object in place: string values are unescaped over their own bytes
+// (never longer than the escaped form), so no allocation is needed. Only the keys the
+// import cares about are kept; anything nested is rejected.
+static void parseNdjsonRow(char *p, char *end, const char *base, ImportRow &row) {
+    string_view type, start, finish, date, symptoms, mood;
+    auto ws = [&] { while (p < end && isspace((unsigned char)*p)) ++p; };
+    auto str = [&](string_view &out) {
+        if (p == end || *p != '"') return false;
+        char *w = ++p, *from = p;
+        while (p < end && *p != '"') {
+            if (*p != '\\') { *w++ = *p++; continue; }
+            if (++p == end) return false;
+            char e = *p++;
+            uint32_t cp;
+            switch (e) {
+                case 'n': *w++ = '\n'; break;
+                case 't': *w++ = '\t'; break;
+                case 'r': *w++ = '\r'; break;
+                case 'b': *w++ = '\b'; break;
+                case 'f': *w++ = '\f'; break;
+                case 'u':
+                    if (!hex4(p, end, cp)) return false;
+                    p += 4;
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        uint32_t lo;
+                        if (end - p >= 6 && p[0] == '\\' && p[1] == 'u' && hex4(p + 2, end, lo) && lo >= 0xDC00 && lo < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                            p += 6;
+                        } else cp = '?';
+                    } else if (cp >= 0xDC00 && cp < 0xE000) cp = '?';
+                    w = putUtf8(w, cp);
+                    break;
+                default: *w++ = e; break; // \" \\ \/
+            }
+        }
+        if (p == end) return false;
+        ++p;
+        out = string_view(from, size_t(w - from));
+        return true;
+    };
+    ws();
+    if (p == end || *p++ != '{') { row.error = "expected a JSON object"; return; }
+    ws();
+    if (p < end && *p == '}') ++p;
+    else for (;;) {
+        string_view key, value;
+        ws();
+        if (!str(key)) { row.error = "invalid JSON key"; return; }
+        ws();
+        if (p == end || *p++ != ':') { row.error = "expected ':'"; return; }
+        ws();
+        if (p < end && *p == '"') {
+            if (!str(value)) { row.error = "invalid JSON string"; return; }
+        } else {
+            char *from = p;
+            while (p < end && *p != ',' && *p != '}' && !isspace((unsigned char)*p)) ++p;
+            value = string_view(from, size_t(p - from));
+            if (value.empty() || value[0] == '{' || value[0] == '[') { row.error = "unsupported JSON value"; return; }
+        }
+        if (key == "type") type = value;
+        else if (key == "start") start = value;
+        else if (key == "end") finish = value;
+        else if (key == "date") date = value;
+        else if (key == "symptoms") symptoms = value;
+        else if (key == "mood") mood = value;
+        ws();
+        if (p < end && *p == ',') { ++p; continue; }
+        if (p < end && *p == '}') { ++p; break; }
+        row.error = "expected ',' or '}'";
+        return;
+    }
+    ws();
+    if (p != end) { row.error = "trailing data after JSON object"; return; }
+    row.cycle = type.empty() ? !start.empty() : type == "cycle";
+    if (!row.cycle && !type.empty() && type != "log") { row.error = "unknown record type"; return; }
+    string_view f[3] = {row.cycle ? start : date, row.cycle ? finish : symptoms, row.cycle ? string_view() : mood};
+    for (int i = 0; i < 3; ++i) { row.off[i] = uint32_t(f[i].data() ? f[i].data() - base : 0); row.len[i] = uint32_t(f[i].size()); }
+}
+
+static void parseCsvRow(string_view line, const char *base, vector<string_view> &parts, ImportRow &row) {
+    parts.clear();
+    for (size_t b = 0;;) {
+        size_t c = line.find(',', b);
+        parts.push_back(trim(line.substr(b, c == string_view::npos ? string_view::npos : c - b)));
+        if (c == string_view::npos) break;
+        b = c + 1;
+    }
+    size_t skip = 0;
+    if (parts[0] == "cycle" || parts[0] == "log") { row.cycle = parts[0] == "cycle"; skip = 1; }
+    else if (parts.size() == 4 || parts.size() == 3) row.cycle = parts.size() == 4;
+    else { row.error = "expected a cycle or log row"; return; }
+    size_t need = row.cycle ? 2 : 3;
+    if (parts.size() < skip + need) { row.error = row.cycle ? "cycle row needs start and end" : "log row needs date, symptoms and mood"; return; }
+    for (size_t i = 0; i < need; ++i) {
+        row.off[i] = uint32_t(parts[skip + i].data() - base);
+        row.len[i] = uint32_t(parts[skip + i].size());
+    }
+}
+
+// Splits chunk.text (whole lines only) into rows; blank lines and '#' comments are skipped.
+static void parseImportChunk(ImportChunk &chunk, StreamFormat fmt, size_t &lineNo) {
+    char *base = chunk.text.data(), *end = base + chunk.text.size();
+    vector<string_view> parts;
+    for (char *p = base; p < end;) {
+        char *nl = static_cast<char *>(memchr(p, '\n', size_t(end - p)));
+        char *stop = nl ? nl : end;
+        ++lineNo;
+        string_view line = trim(string_view(p, size_t(stop - p)));
+        if (!line.empty() && line[0] != '#') {
+            ImportRow row;
+            row.line = lineNo;
+            if (fmt == StreamFormat::Csv) parseCsvRow(line, base, parts, row);
+            else parseNdjsonRow(const_cast<char *>(line.data()), const_cast<char *>(line.data() + line.size()), base, row);
+            chunk.rows.push_back(row);
+        }
+        p = stop + 1;
+    }
+}
+
+// Control characters would break the one-record-per-line files; they become spaces.
+static string cleanText(string_view s) {
+    string out(trim(s));
+    for (char &c : out) if ((unsigned char)c < 0x20) c = ' ';
+    return out;
+}
+
+static void appendDate(string &out, Date d) {
+    char buf[10];
+    out.append(buf, size_t(formatDate(d, buf) - buf));
+}
+
+static void appendInt(string &out, int v) {
+    char buf[16];
+    out.append(buf, size_t(to_chars(buf, buf + sizeof buf, v).ptr - buf));
+}
+
+static void appendJsonString(string &out, string_view s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof buf, "\\u%04x", unsigned(c));
+            out += buf;
+        } else out += c;
+    }
+    out += '"';
+}
+
+static void appendCycleRecord(string &out, const CycleEntry &c, StreamFormat fmt) {
+    if (fmt == StreamFormat::Csv) {
+        out += "cycle,"; appendDate(out, c.startDate); out += ','; appendDate(out, c.endDate); out += ',';
+        appendInt(out, c.durationDays); out += ','; appendInt(out, c.cycleLength); out += '\n';
+    } else {
+        out += "{\"type\":\"cycle\",\"start\":\""; appendDate(out, c.startDate);
+        out += "\",\"end\":\""; appendDate(out, c.endDate);
+        out += "\",\"duration\":"; appendInt(out, c.durationDays);
+        out += ",\"cycleLength\":"; appendInt(out, c.cycleLength); out += "}\n";
+    }
+}
+
+static void appendLogRecord(string &out, Date d, const DailyLog &l, const StringPool &pool, StreamFormat fmt) {
+    if (fmt == StreamFormat::Csv) {
+        auto field = [&](string_view s) { for (char c : s) out += c == ',' ? ';' : c; };
+        out += "log,"; appendDate(out, d); out += ',';
+        field(pool.str(l.symptoms)); out += ','; field(pool.str(l.mood)); out += '\n';
+    } else {
+        out += "{\"type\":\"log\",\"date\":\""; appendDate(out, d);
+        out += "\",\"symptoms\":"; appendJsonString(out, pool.str(l.symptoms));
+        out += ",\"mood\":"; appendJsonString(out, pool.str(l.mood)); out += "}\n";
+    }
+}
+
+// ---------- Binary snapshot ----------
+// tracker.snap mirrors cycles.csv/daily_logs.csv for fast cold starts: a header, a block
+// index, fixed 12-byte cycle and log records, then a string table holding each distinct
+// symptoms/mood text once. The header records the size and mtime of both CSVs as they
+// were written alongside it; if either CSV changed since (e.g. edited or imported by
+// hand) the snapshot is ignored and the CSVs are parsed instead.
+//
+// Logs are sorted by day and grouped into the log table's 512-day blocks. The index gives
+// each block's first record and the byte range its rows occupy in daily_logs.csv, so a
+// tracker can leave blocks in the mapping until their days are used, and a save can copy
+// the CSV rows of blocks nobody touched straight across.
+struct FileStamp {
+    int64_t size = -1, mtimeNs = 0;
+    bool operator==(const FileStamp &o) const { return size == o.size && mtimeNs == o.mtimeNs; }
+};
+
+static FileStamp stampOf(const string &path) {
+    struct stat st;
+    FileStamp fs;
+    if (stat(path.c_str(), &st) == 0) { fs.size = st.st_size; fs.mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec; }
+    return fs;
+}
+
+constexpr uint32_t kSnapVersion = 2, kSnapByteOrder = 0x01020304;
+constexpr uint64_t kUnknownOffset = UINT64_MAX; // CSV position not known (snapshot written on its own)
+
+struct SnapHeader {
+    char magic[4];
+    uint32_t version, byteOrder;
+    uint32_t cycleCount, logCount, stringCount, stringBytes, blockCount;
+    FileStamp cyclesCsv, logsCsv;
+};
+struct SnapBlock { int32_t block; uint32_t firstLog; uint64_t csvOffset, csvBytes; };
+struct SnapCycle { int32_t start, end; int16_t duration, length; };
+struct SnapLog { int32_t day; uint32_t symptoms, mood; }; // string table indices
+static_assert(sizeof(SnapHeader) == 64 && sizeof(SnapBlock) == 24 && sizeof(SnapCycle) == 12 && sizeof(SnapLog) == 12,
+              "snapshot layout");
+
+class MappedFile {
+    void *addr = MAP_FAILED;
+    size_t len = 0;
+
+public:
+    explicit MappedFile(const string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            len = size_t(st.st_size);
+            addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+    }
+    ~MappedFile() { if (addr != MAP_FAILED) munmap(addr, len); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return addr == MAP_FAILED ? nullptr : static_cast<const char *>(addr); }
+    size_t size() const { return len; }
+};
+
+// Validates a mapped snapshot and exposes its records in place. Log records are only
+// checked when read (logValid), so opening never touches pages of logs nobody asks for.
+class SnapshotReader {
+    MappedFile file;
+    const SnapHeader *hdr = nullptr;
+    const SnapBlock *blockRecs = nullptr;
+    const SnapCycle *cycleRecs = nullptr;
+    const SnapLog *logRecs = nullptr;
+    const uint32_t *offsets = nullptr;
+    const char *blob = nullptr;
+
+public:
+    SnapshotReader(const string &path, FileStamp cyclesCsv, FileStamp logsCsv) : file(path) {
+        const char *p = file.data();
+        if (!p || file.size() < sizeof(SnapHeader)) return;
+        const SnapHeader *h = reinterpret_cast<const SnapHeader *>(p);
+        if (memcmp(h->magic, "PTSN", 4) != 0 || h->version != kSnapVersion || h->byteOrder != kSnapByteOrder) return;
+        if (!(h->cyclesCsv == cyclesCsv) || !(h->logsCsv == logsCsv)) return;
+        uint64_t need = sizeof(SnapHeader) + uint64_t(h->blockCount) * sizeof(SnapBlock) + uint64_t(h->cycleCount) * sizeof(SnapCycle)
+                      + uint64_t(h->logCount) * sizeof(SnapLog) + (uint64_t(h->stringCount) + 1) * sizeof(uint32_t) + h->stringBytes;
+        if (need != file.size()) return;
+        blockRecs = reinterpret_cast<const SnapBlock *>(p + sizeof(SnapHeader));
+        cycleRecs = reinterpret_cast<const SnapCycle *>(blockRecs + h->blockCount);
+        logRecs = reinterpret_cast<const SnapLog *>(cycleRecs + h->cycleCount);
+        offsets = reinterpret_cast<const uint32_t *>(logRecs + h->logCount);
+        blob = reinterpret_cast<const char *>(offsets + h->stringCount + 1);
+        for (uint32_t i = 0; i < h->stringCount; ++i)
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > h->stringBytes) return;
+        if ((h->blockCount == 0) != (h->logCount == 0) || (h->blockCount && blockRecs[0].firstLog != 0)) return;
+        for (uint32_t i = 1; i < h->blockCount; ++i)
+            if (blockRecs[i].block <= blockRecs[i - 1].block || blockRecs[i].firstLog <= blockRecs[i - 1].firstLog
+                || blockRecs[i].firstLog >= h->logCount) return;
+        hdr = h;
+    }
+
+    bool valid() const { return hdr != nullptr; }
+    uint32_t cycleCount() const { return hdr->cycleCount; }
+    uint32_t logCount() const { return hdr->logCount; }
+    uint32_t stringCount() const { return hdr->stringCount; }
+    uint32_t blockCount() const { return hdr->blockCount; }
+    const SnapCycle &cycle(uint32_t i) const { return cycleRecs[i]; }
+    const SnapLog &log(uint32_t i) const { return logRecs[i]; }
+    const SnapBlock &block(uint32_t i) const { return blockRecs[i]; }
+    uint32_t blockEnd(uint32_t i) const { return i + 1 < hdr->blockCount ? blockRecs[i + 1].firstLog : hdr->logCount; }
+    // Log i has valid string indices and lies in block b.
+    bool logValid(uint32_t i, uint32_t b) const {
+        const SnapLog &l = logRecs[i];
+        return l.symptoms < hdr->stringCount && l.mood < hdr->stringCount && LogTable::blockOf(Date(l.day)) == blockRecs[b].block;
+    }
+    string_view str(uint32_t idx) const { return string_view(blob + offsets[idx], offsets[idx + 1] - offsets[idx]); }
+};
+
+// Collects records for a new tracker.snap. Logs must arrive in date order; when they are
+// written next to a daily_logs.csv being produced, passing that FILE records where each
+// block's rows start so later saves can copy them. Texts are numbered by content, since
+// they may come from the string pool or from an older snapshot's table.
+class SnapshotWriter {
+    vector<SnapBlock> blocks;
+    vector<SnapCycle> cyc;
+    vector<SnapLog> logs;
+    unordered_map<string_view, uint32_t> ids;
+    vector<string_view> strings;
+    bool fits = true, blocksClosed = false;
+
+    uint32_t text(string_view s) {
+        auto res = ids.emplace(s, uint32_t(strings.size()));
+        if (res.second) strings.push_back(s);
+        return res.first->second;
+    }
+
+    void closeBlock(FILE *csv) {
+        if (blocks.empty()) return;
+        SnapBlock &b = blocks.back();
+        if (b.csvOffset == kUnknownOffset || !csv) { b.csvOffset = kUnknownOffset; return; }
+        off_t at = ftello(csv);
+        b.csvBytes = at < 0 ? 0 : uint64_t(at) - b.csvOffset;
+        if (at < 0) b.csvOffset = kUnknownOffset;
+    }
+
+public:
+    void addCycle(const CycleEntry &c) {
+        auto fits16 = [](int v) { return v >= INT16_MIN && v <= INT16_MAX; };
+        if (!fits16(c.durationDays) || !fits16(c.cycleLength)) { fits = false; return; }
+        cyc.push_back({c.startDate.days, c.endDate.days, int16_t(c.durationDays), int16_t(c.cycleLength)});
+    }
+
+    // Call before the row itself is written to `csv`.
+    void addLog(Date d, string_view symptoms, string_view mood, FILE *csv = nullptr) {
+        int32_t b = LogTable::blockOf(d);
+        if (blocks.empty() || blocks.back().block != b) {
+            closeBlock(csv);
+            off_t at = csv ? ftello(csv) : -1;
+            blocks.push_back({b, uint32_t(logs.size()), at < 0 ? kUnknownOffset : uint64_t(at), 0});
+        }
+        logs.push_back({d.days, text(symptoms), text(mood)});
+    }
+
+    // Ends the last block at the current position of `csv`, once its final row is written.
+    void endLogs(FILE *csv) {
+        closeBlock(csv);
+        blocksClosed = true;
+    }
+
+    // Fails (and writes nothing) if a value did not fit the fixed-width records.
+    bool write(const string &path, FileStamp cyclesCsv, FileStamp logsCsv) {
+        if (!fits) return false;
+        if (!blocksClosed) endLogs(nullptr);
+        vector<uint32_t> offsets{0};
+        for (string_view sv : strings) offsets.push_back(offsets.back() + uint32_t(sv.size()));
+
+        SnapHeader h{};
+        memcpy(h.magic, "PTSN", 4);
+        h.version = kSnapVersion; h.byteOrder = kSnapByteOrder;
+        h.cycleCount = uint32_t(cyc.size()); h.logCount = uint32_t(logs.size());
+        h.stringCount = uint32_t(strings.size()); h.stringBytes = offsets.back();
+        h.blockCount = uint32_t(blocks.size());
+        h.cyclesCsv = cyclesCsv; h.logsCsv = logsCsv;
+
+        const string tmp = path + ".tmp";
+        FILE *fp = fopen(tmp.c_str(), "wb");
+        if (!fp) return false;
+        auto put = [fp](const void *p, size_t size, size_t n) { if (n) fwrite(p, size, n, fp); }; // data() may be null when empty
+        put(&h, sizeof h, 1);
+        put(blocks.data(), sizeof(SnapBlock), blocks.size());
+        put(cyc.data(), sizeof(SnapCycle), cyc.size());
+        put(logs.data(), sizeof(SnapLog), logs.size());
+        put(offsets.data(), sizeof(uint32_t), offsets.size());
+        for (string_view sv : strings) put(sv.data(), 1, sv.size());
+        bool ok = !ferror(fp);
+        ok = fclose(fp) == 0 && ok;
+        return ok && rename(tmp.c_str(), path.c_str()) == 0;
+    }
+};
+
+// A tracker's lazily paged logs: the snapshot it loaded, kept mapped, plus daily_logs.csv
+// held open as it was when that snapshot was stamped. Both stay readable after a save
+// renames new files over them, so blocks never paged in can always be copied forward.
+struct LogSource {
+    SnapshotReader snap;
+    int csvFd = -1; // -1 if the CSV no longer matches the stamp; rows are then re-formatted
+
+    LogSource(const string &snapPath, const string &logsPath, FileStamp cyclesCsv, FileStamp logsCsv)
+        : snap(snapPath, cyclesCsv, logsCsv) {
+        if (!snap.valid() || (csvFd = ::open(logsPath.c_str(), O_RDONLY)) < 0) return;
+        struct stat st;
+        if (fstat(csvFd, &st) != 0 || st.st_size != logsCsv.size
+            || int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec != logsCsv.mtimeNs) { ::close(csvFd); csvFd = -1; }
+    }
+    ~LogSource() { if (csvFd >= 0) ::close(csvFd); }
+    LogSource(const LogSource &) = delete;
+    LogSource &operator=(const LogSource &) = delete;
+
+    // Appends block b to a save in progress: its records to `out`, and its CSV rows to `csv`,
+    // as a raw byte copy when the old file's range is known.
+    bool copyBlock(uint32_t b, SnapshotWriter &out, FILE *csv) const {
+        const SnapBlock &blk = snap.block(b);
+        bool raw = csvFd >= 0 && blk.csvOffset != kUnknownOffset;
+        for (uint32_t i = blk.firstLog, e = snap.blockEnd(b); i < e && raw; ++i) raw = snap.logValid(i, b);
+        for (uint32_t i = blk.firstLog, e = snap.blockEnd(b); i < e; ++i) {
+            if (!snap.logValid(i, b)) continue;
+            const SnapLog &l = snap.log(i);
+            out.addLog(Date(l.day), snap.str(l.symptoms), snap.str(l.mood), csv);
+            if (!raw) writeLogRow(csv, Date(l.day), snap.str(l.symptoms), snap.str(l.mood));
+        }
+        if (!raw) return true;
+        char buf[1 << 16];
+        for (uint64_t done = 0; done < blk.csvBytes;) {
+            ssize_t got = pread(csvFd, buf, size_t(min<uint64_t>(sizeof buf, blk.csvBytes - done)), off_t(blk.csvOffset + done));
+            if (got <= 0) return false;
+            fwrite(buf, 1, size_t(got), csv);
+            done += uint64_t(got);
+        }
+        return true;
+    }
+};
+
+// Snapshot of fully resident data, written on its own (block CSV ranges unknown).
+static bool writeBinarySnapshot(const string &path, const CycleStore &snapCycles, const LogTable &snapLogs,
+                                const StringPool &pool, FileStamp cyclesCsv, FileStamp logsCsv) {
+    SnapshotWriter out;
+    for (const auto &c : snapCycles) out.addCycle(c);
+    snapLogs.forEach([&](Date d, const DailyLog &l) { out.addLog(d, pool.str(l.symptoms), pool.str(l.mood)); });
+    return out.write(path, cyclesCsv, logsCsv);
+}
+
+// Immutable digest of the cycle history. It is republished after every cycle edit by an
+// atomic pointer swap, so prediction/analytics readers never wait on the writer lock.
+struct CycleSummary {
+    size_t cycleCount = 0;
+    Date lastStart;
+    double durAvg = 0, durMedian = 0;
+    int durMin = 0, durMax = 0;
+    size_t lengthCount = 0;
+    double lenAvg = 0, lenMedian = 0, lenStddev = 0;
+    int lenMin = 0, lenMax = 0;
+    // The same lengths over the window of recent cycles, with robust estimators.
+    size_t windowSize = 0, windowCount = 0;
+    double winMedian = 0, winTrimmedMean = 0, winMad = 0;
+    int winMin = 0, winMax = 0, winTrimmedRange = 0;
+    size_t winOutliers = 0; // further than kOutlierDays and 3 robust standard deviations
+    static constexpr double kMadToSd = 1.4826, kOutlierDays = 7;
+    double winRobustSd() const { return kMadToSd * winMad; }
+};
+
+// Cycles whose shortest and longest length differ by more than 9 days are commonly
+// classed as irregular. Judged on the recent window with its extremes trimmed, so an
+// old or single odd cycle does not mark a user irregular for good.
+inline bool isIrregular(const CycleSummary &s) { return s.windowCount >= 2 && s.winTrimmedRange > 9; }
+
+// Mergeable accumulator for analytics across many users. Histograms are exact for
+// lengths below kLengthBuckets (the last bucket collects everything longer).
+struct PopulationStats {
+    static constexpr int kLengthBuckets = 121, kDurationBuckets = 16;
+    uint64_t users = 0, usersWithLengths = 0, irregularUsers = 0, cycles = 0;
+    uint64_t lengthCount = 0, lengthSum = 0;
+    array<uint64_t, kLengthBuckets> lengthHist{};
+    array<uint64_t, kDurationBuckets> durationHist{};
+
+    // Counts and sums come from the column kernels; this only bins one cycle.
+    void addHistogram(int durationDays, int cycleLength) {
+        durationHist[size_t(clamp(durationDays, 0, kDurationBuckets - 1))]++;
+        if (cycleLength > 0) lengthHist[size_t(min(cycleLength, kLengthBuckets - 1))]++;
+    }
+
+    void merge(const PopulationStats &o) {
+        users += o.users; usersWithLengths += o.usersWithLengths; irregularUsers += o.irregularUsers;
+        cycles += o.cycles; lengthCount += o.lengthCount; lengthSum += o.lengthSum;
+        for (int i = 0; i < kLengthBuckets; ++i) lengthHist[i] += o.lengthHist[i];
+        for (int i = 0; i < kDurationBuckets; ++i) durationHist[i] += o.durationHist[i];
+    }
+
+    double meanLength() const { return lengthCount ? double(lengthSum) / lengthCount : 0; }
+
+    int lengthPercentile(double q) const {
+        uint64_t rank = uint64_t(q * double(lengthCount)), seen = 0;
+        for (int i = 0; i < kLengthBuckets; ++i) if ((seen += lengthHist[i]) > rank) return i;
+        return kLengthBuckets - 1;
+    }
+};
+
+// ---------- Undo log ----------
+// Bounded command history: a fixed ring of compact records, so memory stays flat however
+// long a session runs; once full, the oldest edit is forgotten. A cycle record carries
+// everything needed to apply it either way. A daily-log record's before/after text lives
+// in the revision slot parallel to it.
+enum class OpKind : uint8_t { AddCycle, RemoveCycle, SetLog };
+
+struct OpRecord {
+    OpKind op = OpKind::AddCycle;
+    int32_t day = 0;          // cycle start / log date
+    int32_t payload[3] = {};  // cycles: end day, duration, cycle length
+};
+
+struct LogRevision { bool hadBefore = false; DailyLog before, after; };
+
+class OpLog {
+    vector<OpRecord> ring;
+    vector<LogRevision> revisions;
+    size_t head = 0;   // slot of the oldest record
+    size_t count = 0;  // undoable + redoable records
+    size_t cursor = 0; // undoable records
+
+    size_t slot(size_t i) const { return (head + i) % ring.size(); }
+
+public:
+    static constexpr size_t kDefaultDepth = 256;
+
+    explicit OpLog(size_t depth = kDefaultDepth) { setDepth(depth); }
+
+    // Resizing forgets the current history.
+    void setDepth(size_t depth) {
+        ring.assign(max<size_t>(depth, 1), OpRecord{});
+        revisions.assign(ring.size(), LogRevision{});
+        head = count = cursor = 0;
+    }
+    size_t depth() const { return ring.size(); }
+
+    // Records a new edit and drops anything that could have been redone. Returns its slot.
+    size_t push(const OpRecord &r) {
+        count = cursor;
+        if (count == ring.size()) { head = slot(1); --count; }
+        size_t s = slot(count);
+        ring[s] = r;
+        revisions[s] = LogRevision{};
+        cursor = ++count;
+        return s;
+    }
+
+    const OpRecord &at(size_t s) const { return ring[s]; }
+    LogRevision &revision(size_t s) { return revisions[s]; }
+
+    // Slot the next undo / redo would apply; the cursor only moves once it succeeded.
+    optional<size_t> nextUndo() const { return cursor ? optional<size_t>(slot(cursor - 1)) : nullopt; }
+    optional<size_t> nextRedo() const { return cursor < count ? optional<size_t>(slot(cursor)) : nullopt; }
+    void undone() { --cursor; }
+    void redone() { ++cursor; }
+};
+
+// Outcome of a core PeriodTracker edit; front-ends turn it into a message.
+enum class EditResult { Ok, Removed, Restored, LogChanged, Nothing, EndBeforeStart, Duplicate, NotFound, Conflict };
+
+// ---------- Prediction models ----------
+// A predictor only estimates the next cycle length from the recorded lengths (never
+// empty); ovulation and the fertile window follow from the usual 14-day luteal phase.
+struct Prediction {
+    bool valid = false; // false until a cycle is recorded
+    int cycleLength = 28;
+    Date nextStart, ovulation, fertileFrom, fertileTo;
+};
+
+// What a predictor sees of the history: the running length stats, read in O(1), and the
+// lengths themselves walked back from the newest cycle on demand, so a model that only
+// looks at the last few cycles never touches the rest.
+class LengthHistory {
+    const CycleStore &cycles;
+    const RunningStats &stats; // over cycleLength > 0
+
+public:
+    LengthHistory(const CycleStore &store, const RunningStats &lengthStats) : cycles(store), stats(lengthStats) {}
+
+    size_t count() const { return stats.count(); }
+    long long sum() const { return stats.sum(); }
+
+    // The last n lengths (fewer if there are not that many), oldest first.
+    vector<int> recent(size_t n) const {
+        vector<int> out;
+        out.reserve(min(n, count()));
+        for (auto it = cycles.end(); out.size() < n && it != cycles.begin();) {
+            int len = (*--it).cycleLength;
+            if (len > 0) out.push_back(len);
+        }
+        reverse(out.begin(), out.end());
+        return out;
+    }
+    vector<int> all() const { return recent(count()); }
+};
+
+class Predictor {
+public:
+    virtual ~Predictor() = default;
+    virtual const char *name() const = 0;
+    virtual int cycleLength(const LengthHistory &lengths) const = 0;
+
+    Prediction predict(Date lastStart, const LengthHistory &lengths) const {
+        Prediction p;
+        p.valid = true;
+        p.cycleLength = lengths.count() == 0 ? 28 : max(1, cycleLength(lengths));
+        p.nextStart = addDays(lastStart, p.cycleLength);
+        p.ovulation = addDays(p.nextStart, -14);
+        p.fertileFrom = addDays(p.ovulation, -5);
+        p.fertileTo = addDays(p.ovulation, 1);
+        return p;
+    }
+};
+
+// Integer mean of every length (the original behaviour).
+class MeanPredictor : public Predictor {
+public:
+    const char *name() const override { return "mean"; }
+    int cycleLength(const LengthHistory &lengths) const override {
+        return int(lengths.sum() / (long long)lengths.count());
+    }
+};
+
+// Mean of the last 6 lengths, weighted 1..6 towards the most recent.
+class RecentPredictor : public Predictor {
+public:
+    const char *name() const override { return "recent"; }
+    int cycleLength(const LengthHistory &lengths) const override {
+        vector<int> tail = lengths.recent(6);
+        double sum = 0, weights = 0;
+        for (size_t i = 0; i < tail.size(); ++i) { sum += double(i + 1) * tail[i]; weights += double(i + 1); }
+        return int(lround(sum / weights));
+    }
+};
+
+// Median of the last 12 lengths, so one unusual cycle barely moves it.
+class MedianPredictor : public Predictor {
+public:
+    const char *name() const override { return "median"; }
+    int cycleLength(const LengthHistory &lengths) const override {
+        vector<int> tail = lengths.recent(12);
+        size_t mid = tail.size() / 2;
+        nth_element(tail.begin(), tail.begin() + ptrdiff_t(mid), tail.end());
+        if (tail.size() % 2) return tail[mid];
+        int upper = tail[mid];
+        int lower = *max_element(tail.begin(), tail.begin() + ptrdiff_t(mid));
+        return int(lround((lower + upper) / 2.0));
+    }
+};
+
+// Exponential smoothing (alpha 0.3): follows a drifting cycle length over the years.
+class SmoothingPredictor : public Predictor {
+public:
+    const char *name() const override { return "smooth"; }
+    int cycleLength(const LengthHistory &history) const override {
+        vector<int> lengths = history.all();
+        double level = lengths[0];
+        for (size_t i = 1; i < lengths.size(); ++i) level += 0.3 * (lengths[i] - level);
+        return int(lround(level));
+    }
+};
+
+static constexpr const char *kPredictorNames = "mean, recent, median, smooth";
+
+static shared_ptr<const Predictor> makePredictor(string_view name) {
+    if (name == "mean") return make_shared<MeanPredictor>();
+    if (name == "recent") return make_shared<RecentPredictor>();
+    if (name == "median") return make_shared<MedianPredictor>();
+    if (name == "smooth") return make_shared<SmoothingPredictor>();
+    return nullptr;
+}
+
+// ---------- Projection ----------
+// Periods, fertile windows and PMS windows laid out cycle after cycle from a prediction,
+// for as far ahead as anyone asks. Nothing is stored per event: event i is computed from
+// four numbers, so the schedule is a range generated on demand, a long horizon costs no
+// more than a short one, and continuing a pull never recomputes what came before.
+enum class ProjectedKind : uint8_t { Fertile, Pms, Period };
+
+static const char *projectedKindName(ProjectedKind k) {
+    switch (k) {
+        case ProjectedKind::Fertile: return "Fertile window";
+        case ProjectedKind::Pms: return "PMS window";
+        default: return "Period";
+    }
+}
+
+struct ProjectedEvent {
+    ProjectedKind kind;
+    int cycle; // 0 = the cycle that starts at the predicted next period
+    Date from, to;
+};
+
+class Projection {
+    Date firstStart;
+    int length, duration;
+    const char *model;
+
+public:
+    static constexpr int kEventsPerCycle = 3, kPmsDays = 7;
+
+    Projection(const Prediction &p, int periodDays, const char *modelName)
+        : firstStart(p.nextStart), length(max(1, p.cycleLength)), duration(max(1, periodDays)), model(modelName) {}
+
+    int cycleLength() const { return length; }
+    int periodDays() const { return duration; }
+    const char *modelName() const { return model; }
+
+    // For projected cycle k (starting at firstStart + k * length): the fertile window and
+    // PMS days of the cycle leading up to it, then the period itself. Ovulation is taken
+    // as 14 days before the start, as in Predictor::predict.
+    ProjectedEvent event(size_t i) const {
+        int k = int(i / kEventsPerCycle);
+        Date start = addDays(firstStart, k * length);
+        switch (i % kEventsPerCycle) {
+            case 0: return {ProjectedKind::Fertile, k, addDays(start, -19), addDays(start, -13)};
+            case 1: return {ProjectedKind::Pms, k, addDays(start, -kPmsDays), addDays(start, -1)};
+            default: return {ProjectedKind::Period, k, start, addDays(start, duration)}; // end as CycleEntry has it
+        }
+    }
+
+    // Index of the first event still running on or after `d`, found in O(1).
+    size_t firstIndexFrom(Date d) const {
+        long long k = max(0LL, (long long)daysBetween(firstStart, d) / length - 1);
+        size_t i = size_t(k) * kEventsPerCycle;
+        while (event(i).to < d) ++i;
+        return i;
+    }
+
+    // Calls f(event) for each event overlapping [from, to], generating them as it goes.
+    template <class F> void forEach(Date from, Date to, F &&f) const {
+        for (size_t i = firstIndexFrom(from);; ++i) {
+            ProjectedEvent e = event(i);
+            if (to < e.from) break;
+            f(e);
+        }
+    }
+};
+
+// Per-tracker settings taken from the command line.
+struct TrackerOptions {
+    size_t undoDepth = OpLog::kDefaultDepth;
+    shared_ptr<const Predictor> predictor = make_shared<MeanPredictor>();
+    chrono::milliseconds saveDebounce{2000}; // quiet time after the last edit before saving
+    int horizonMonths = 12;                   // how far ahead reminders show projected events
+    size_t statsWindow = 12;                  // recent cycles covered by the windowed statistics
+    bool readOnly = false;                    // load for reporting only: no journal, nothing written back
+};
+
+// ---------- Calendar feed ----------
+// What calendar clients poll for: upcoming reminders and projected events, serialised
+// once per data version as complete HTTP responses (iCalendar, JSON and the 304), so a
+// poll is a lookup and a single write. The version is also the ETag, and a client that
+// sends back an older one gets only the events added or removed since (feedDelta).
+struct FeedItem {
+    string uid, summary;
+    const char *kind; // reminder / fertile / pms / period
+    Date from, to;    // inclusive
+};
+
+static bool operator==(const FeedItem &a, const FeedItem &b) {
+    return a.uid == b.uid && a.summary == b.summary && a.from == b.from && a.to == b.to;
+}
+
+struct Feed {
+    string version, etag; // etag is the version in quotes, as sent
+    vector<FeedItem> items; // ordered by start date
+    string ics, json, notModified; // complete responses
+    mutable mutex deltaMu;
+    mutable unordered_map<string, string> deltas; // older version -> delta response
+};
+
+static string httpResponse(const char *status, const char *type, const string &etag, string_view body) {
+    string r = "HTTP/1.1 ";
+    r += status;
+    r += "\r\nContent-Type: ";
+    r += type;
+    r += "\r\nContent-Length: ";
+    r += to_string(body.size());
+    if (!etag.empty()) r += "\r\nETag: " + etag;
+    r += "\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n";
+    r += body;
+    return r;
+}
+
+static void appendIcsDate(string &out, Date d) {
+    char buf[10];
+    formatDate(d, buf); // YYYY-MM-DD -> YYYYMMDD
+    out.append(buf, 4).append(buf + 5, 2).append(buf + 8, 2);
+}
+
+// One content line: text escaped per RFC 5545 and folded at 75 octets, never inside a
+// UTF-8 sequence.
+static void appendIcsLine(string &out, string_view name, string_view value, bool escape = false) {
+    string line(name);
+    line += ':';
+    for (char c : value) {
+        if (escape && (c == '\\' || c == ';' || c == ',')) line += '\\';
+        line += (unsigned char)c < 0x20 ? ' ' : c;
+    }
+    size_t pos = 0;
+    for (size_t limit = 75; line.size() - pos > limit; limit = 74) {
+        size_t cut = pos + limit;
+        while (cut > pos + 1 && (line[cut] & 0xC0) == 0x80) --cut;
+        out.append(line, pos, cut - pos).append("\r\n ");
+        pos = cut;
+    }
+    out.append(line, pos, string::npos).append("\r\n");
+}
+
+static void appendFeedItemJson(string &out, const FeedItem &it) {
+    out += "{\"uid\":";
+    appendJsonString(out, it.uid);
+    out += ",\"kind\":\"";
+    out += it.kind;
+    out += "\",\"start\":\"";
+    appendDate(out, it.from);
+    out += "\",\"end\":\"";
+    appendDate(out, it.to);
+    out += "\",\"summary\":";
+    appendJsonString(out, it.summary);
+    out += '}';
+}
+
+static shared_ptr<Feed> buildFeed(string version, vector<FeedItem> items, Date stamp) {
+    auto f = make_shared<Feed>();
+    f->version = move(version);
+    f->etag = '"' + f->version + '"';
+    f->items = move(items);
+    string ics = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Period Tracker//EN\r\nCALSCALE:GREGORIAN\r\n"
+                 "X-WR-CALNAME:Period tracker\r\n";
+    string dtstamp;
+    appendIcsDate(dtstamp, stamp);
+    dtstamp += "T000000Z";
+    string json = "{\"version\":";
+    appendJsonString(json, f->version);
+    json += ",\"generated\":\"";
+    appendDate(json, stamp);
+    json += "\",\"events\":[";
+    for (size_t i = 0; i < f->items.size(); ++i) {
+        const FeedItem &it = f->items[i];
+        string start, end;
+        appendIcsDate(start, it.from);
+        appendIcsDate(end, addDays(it.to, 1)); // DTEND is exclusive
+        ics += "BEGIN:VEVENT\r\n";
+        appendIcsLine(ics, "UID", it.uid);
+        appendIcsLine(ics, "DTSTAMP", dtstamp);
+        appendIcsLine(ics, "DTSTART;VALUE=DATE", start);
+        appendIcsLine(ics, "DTEND;VALUE=DATE", end);
+        appendIcsLine(ics, "SUMMARY", it.summary, true);
+        appendIcsLine(ics, "CATEGORIES", it.kind);
+        appendIcsLine(ics, "TRANSP", "TRANSPARENT");
+        ics += "END:VEVENT\r\n";
+        if (i) json += ',';
+        appendFeedItemJson(json, it);
+    }
+    ics += "END:VCALENDAR\r\n";
+    json += "]}\n";
+    f->ics = httpResponse("200 OK", "text/calendar; charset=utf-8", f->etag, ics);
+    f->json = httpResponse("200 OK", "application/json", f->etag, json);
+    f->notModified = httpResponse("304 Not Modified", "text/plain", f->etag, "");
+    return f;
+}
+
+// The events of `to` that are new or changed since `from`, and the uids that are gone.
+static string feedDelta(const Feed &from, const Feed &to) {
+    unordered_map<string_view, const FeedItem *> old;
+    for (const FeedItem &it : from.items) old.emplace(it.uid, &it);
+    string json = "{\"version\":";
+    appendJsonString(json, to.version);
+    json += ",\"since\":";
+    appendJsonString(json, from.version);
+    json += ",\"added\":[";
+    bool first = true;
+    for (const FeedItem &it : to.items) {
+        auto o = old.find(it.uid);
+        if (o != old.end()) {
+            bool same = *o->second == it;
+            old.erase(o);
+            if (same) continue;
+        }
+        if (!first) json += ',';
+        first = false;
+        appendFeedItemJson(json, it);
+    }
+    json += "],\"removed\":[";
+    first = true;
+    for (const FeedItem &it : from.items) { // in feed order, not hash order
+        if (!old.count(it.uid)) continue;
+        if (!first) json += ',';
+        first = false;
+        appendJsonString(json, it.uid);
+    }
+    json += "]}\n";
+    return httpResponse("200 OK", "application/json", to.etag, json);
+}
+
+// ---------- Background saver ----------
+// One worker thread shared by every tracker in the process (a store may hold thousands)
+// writes snapshots off the interactive path. Each tracker has at most one queue entry,
+// keyed by when it next wants to save; the tracker itself decides, when its turn comes,
+// whether it is quiet enough yet or should be asked again later.
+class PeriodTracker;
+
+class BackgroundSaver {
+    using Clock = chrono::steady_clock;
+    mutex mu;
+    condition_variable cv;
+    multimap<Clock::time_point, PeriodTracker *> queue;
+    unordered_map<PeriodTracker *, multimap<Clock::time_point, PeriodTracker *>::iterator> queued;
+    PeriodTracker *busy = nullptr; // tracker being saved right now
+    bool stopping = false;
+    thread worker;
+
+    void scheduleLocked(PeriodTracker *t, Clock::time_point due) {
+        auto it = queued.find(t);
+        if (it != queued.end()) {
+            if (it->second->first <= due) return;
+            queue.erase(it->second);
+            queued.erase(it);
+        }
+        queued.emplace(t, queue.emplace(due, t));
+        if (!worker.joinable()) worker = thread([this] { run(); });
+        cv.notify_all();
+    }
+
+    void run(); // defined after PeriodTracker
+
+public:
+    static BackgroundSaver &global() {
+        static BackgroundSaver saver;
+        return saver;
+    }
+
+    ~BackgroundSaver() {
+        { lock_guard<mutex> lock(mu); stopping = true; }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    void schedule(PeriodTracker *t, Clock::time_point due) {
+        lock_guard<mutex> lock(mu);
+        scheduleLocked(t, due);
+    }
+
+    // Drops t's entry, waiting out a save of t already in progress.
+    void cancel(PeriodTracker *t) {
+        unique_lock<mutex> lock(mu);
+        cv.wait(lock, [&] { return busy != t; });
+        auto it = queued.find(t);
+        if (it == queued.end()) return;
+        queue.erase(it->second);
+        queued.erase(it);
+    }
+};
+
+// ---------- PeriodTracker ----------
+class PeriodTracker {
+private:
+    StringPool pool; // texts of this tracker's logs; declared first, the members below use it
+    CycleStore cycles;
+    LogTable dailyLogs;
+    LogIndex logIndex{pool};
+    OpLog history;
+    // The prediction is recomputed at most once per cycleVersion, which cycle edits and
+    // predictor changes bump; predictionMu lets concurrent readers share the cache.
+    shared_ptr<const Predictor> predictor;
+    uint64_t cycleVersion = 0;
+    mutable mutex predictionMu;
+    mutable uint64_t predictionVersion = UINT64_MAX;
+    mutable Prediction cachedPrediction;
+    mutable uint64_t projectionVersion = UINT64_MAX; // same versioning, same lock
+    mutable shared_ptr<const Projection> cachedProjection;
+    const int horizonMonths;
+    // Calendar feed, rebuilt when the cycles, the manual reminders or the day change. The
+    // last few feeds are kept so clients holding one of their versions can get a delta.
+    static constexpr size_t kFeedHistory = 8;
+    const uint64_t feedSerial; // distinguishes versions across reloads and restarts
+    uint64_t reminderVersion = 0;
+    mutable mutex feedMu;
+    shared_ptr<const Feed> cachedFeed;
+    deque<shared_ptr<const Feed>> feedHistory;
+    bool remindersStale = true; // generated reminders are rebuilt lazily when next read
+    ReminderStore manualReminders;    // added by the user, never touched by cycle edits
+    ReminderStore generatedReminders; // derived from the cycle history
+    uint32_t nextReminderId = 1;
+    uint32_t predictedReminderId = 0;
+    Date predictedReminderDate;
+    bool showHeaders = true;
+    size_t pageRows = 0; // listings pause every pageRows rows; 0 = never
+    // Concurrency: edits take `mu` exclusively, listings and prediction take it shared, and
+    // analytics read the published CycleSummary without locking at all.
+    mutable shared_mutex mu;
+    shared_ptr<const CycleSummary> published = make_shared<const CycleSummary>();
+    const string cyclesFile;
+    const string logsFile;
+    const string journalFile;
+    const string snapshotFile;
+    Journal journal{pool};
+    RunningStats durationStats, lengthStats; // lengthStats only counts cycleLength > 0
+    // Lengths of the cycles starting on or after windowFrom, which fitWindow() keeps at the
+    // last statsWindow lengths as cycles are inserted and erased anywhere in the history.
+    WindowedStats recentLengths;
+    Date windowFrom = Date(INT32_MIN);
+    const size_t statsWindow;
+    // Dirty tracking: every edit bumps dataVersion; savedVersion is the version the CSVs
+    // on disk hold. The background saver writes once edits have been quiet for
+    // saveDebounce, but never later than kMaxSaveDelay after the first unsaved edit.
+    static constexpr chrono::seconds kMaxSaveDelay{30};
+    const chrono::milliseconds saveDebounce;
+    const bool readOnly; // edits stay in memory; no journal, no saves
+    uint64_t dataVersion = 0, savedVersion = 0;
+    bool binaryStale = false; // tracker.snap missing or older than the CSVs
+    bool saveQueued = false, saveNow = false;
+    chrono::steady_clock::time_point lastEdit, firstUnsaved;
+    mutex diskMu; // one snapshot write at a time per tracker
+    // Lazy daily logs: after a snapshot load, log blocks stay in logSource's mapping until
+    // a read or edit touches their days (pageIn). paged[i] is set once block i has been
+    // copied into dailyLogs and logIndex; the source is dropped when every block has been.
+    shared_ptr<const LogSource> logSource;
+    vector<bool> paged;
+    size_t unpagedBlocks = 0;
+    vector<uint32_t> sourceIds; // snapshot string index -> pool id, filled as blocks page in
+    atomic<bool> allPaged{true};
+
+    friend class BackgroundSaver;
+
+    void loadData() {
+        PT_TIMED("loadData");
+        bool fromSnapshot = loadBinarySnapshot();
+        if (!fromSnapshot) loadCsv();
+        const string pending = journalFile + ".compacting";
+        if (fileHasData(pending) || fileHasData(journalFile)) savedVersion = UINT64_MAX;
+        replayJournal(pending);
+        replayJournal(journalFile);
+        if (!readOnly && !journal.open(journalFile))
+            cerr << RED << "❌ Cannot open " << journalFile << "; changes will not be saved." << RESET << "\n";
+        binaryStale = !fromSnapshot;
+        cyclesChanged();
+    }
+
+    // Cycles are read straight out of the mapping; logs are left there to page in later.
+    bool loadBinarySnapshot() {
+        auto src = make_shared<const LogSource>(snapshotFile, logsFile, stampOf(cyclesFile), stampOf(logsFile));
+        const SnapshotReader &snap = src->snap;
+        if (!snap.valid()) return false;
+        for (uint32_t i = 0; i < snap.cycleCount(); ++i) {
+            const SnapCycle &c = snap.cycle(i);
+            insertCycle(CycleEntry(Date(c.start), Date(c.end), c.duration, c.length));
+        }
+        if (snap.blockCount() == 0) return true;
+        logSource = move(src);
+        paged.assign(snap.blockCount(), false);
+        unpagedBlocks = snap.blockCount();
+        sourceIds.assign(snap.stringCount(), UINT32_MAX);
+        allPaged = false;
+        return true;
+    }
+
+    // Copies the blocks overlapping [from, to] that are still only in the snapshot into
+    // dailyLogs. Caller holds `mu` exclusively.
+    void pageIn(Date from, Date to) {
+        if (!logSource) return;
+        const SnapshotReader &snap = logSource->snap;
+        uint32_t lo = 0, hi = snap.blockCount();
+        int32_t first = LogTable::blockOf(from), last = LogTable::blockOf(to);
+        while (lo < hi) { uint32_t mid = (lo + hi) / 2; if (snap.block(mid).block < first) lo = mid + 1; else hi = mid; }
+        auto text = [&](uint32_t idx) {
+            if (sourceIds[idx] == UINT32_MAX) sourceIds[idx] = pool.intern(snap.str(idx));
+            return sourceIds[idx];
+        };
+        for (uint32_t b = lo; b < snap.blockCount() && snap.block(b).block <= last; ++b) {
+            if (paged[b]) continue;
+            for (uint32_t i = snap.block(b).firstLog, e = snap.blockEnd(b); i < e; ++i) {
+                const SnapLog &l = snap.log(i);
+                if (snap.logValid(i, b)) storeLog(Date(l.day), DailyLog{text(l.symptoms), text(l.mood)});
+            }
+            paged[b] = true;
+            --unpagedBlocks;
+        }
+        if (unpagedBlocks) return;
+        logSource.reset();
+        paged.clear();
+        sourceIds = {};
+        allPaged = true;
+    }
+
+    // For readers, before taking `mu` shared: pages in [from, to] unless all logs are in.
+    void ensurePaged(Date from, Date to) {
+        if (allPaged.load()) return;
+        unique_lock<shared_mutex> lock(mu);
+        pageIn(from, to);
+    }
+
+    const DailyLog *findLog(Date d) {
+        pageIn(d, d);
+        return dailyLogs.find(d);
+    }
+
+    void loadCsv() {
+        vector<string_view> parts;
+        CsvReader cf(cyclesFile);
+        while (cf.next(parts)) {
+            Date st, en;
+            int d, c;
+            if (parts.size() < 4) reportBadRow(cyclesFile, cf.lineNumber(), "expected 4 fields");
+            else if (!parseDate(parts[0], st) || !parseDate(parts[1], en)) reportBadRow(cyclesFile, cf.lineNumber(), "invalid date");
+            else if (!parseInt(parts[2], d) || !parseInt(parts[3], c)) reportBadRow(cyclesFile, cf.lineNumber(), "invalid number");
+            else if (!insertCycle(CycleEntry(st, en, d, c))) reportBadRow(cyclesFile, cf.lineNumber(), "duplicate start date");
+        }
+        CsvReader lf(logsFile);
+        while (lf.next(parts)) {
+            Date d;
+            if (parts.size() < 3) reportBadRow(logsFile, lf.lineNumber(), "expected 3 fields");
+            else if (!parseDate(parts[0], d)) reportBadRow(logsFile, lf.lineNumber(), "invalid date");
+            else {
+                setLog(d, DailyLog{pool.intern(parts[1]), pool.intern(parts[2])});
+            }
+        }
+    }
+
+    void replayJournal(const string &path) {
+        vector<string_view> parts;
+        CsvReader jr(path);
+        while (jr.next(parts)) {
+            Date st, en;
+            int d, c;
+            if (parts[0] == "+" && parts.size() >= 5 && parseDate(parts[1], st) && parseDate(parts[2], en)
+                && parseInt(parts[3], d) && parseInt(parts[4], c)) {
+                if (!cycles.find(st)) insertCycle(CycleEntry(st, en, d, c));
+            } else if (parts[0] == "-" && parts.size() >= 3 && parseDate(parts[1], st) && parseDate(parts[2], en)) {
+                auto e = cycles.find(st);
+                if (e && e->endDate == en) eraseCycle(*e);
+            } else if (parts[0] == "L" && parts.size() >= 4 && parseDate(parts[1], st)) {
+                setLog(st, DailyLog{pool.intern(parts[2]), pool.intern(parts[3])});
+            } else if (parts[0] == "X" && parts.size() >= 2 && parseDate(parts[1], st)) {
+                eraseLog(st);
+            } else reportBadRow(path, jr.lineNumber(), "unrecognised journal record");
+        }
+    }
+
+    // Called with `mu` held after every edit (not while loading).
+    void markDirty() {
+        ++dataVersion;
+        lastEdit = chrono::steady_clock::now();
+        if (saveQueued || readOnly) return;
+        saveQueued = true;
+        firstUnsaved = lastEdit;
+        BackgroundSaver::global().schedule(this, lastEdit + saveDebounce);
+    }
+
+    // Run by the saver thread when this tracker's entry comes due. Returns the time to
+    // be asked again if edits are still arriving.
+    optional<chrono::steady_clock::time_point> backgroundSave() {
+        {
+            unique_lock<shared_mutex> lock(mu);
+            journal.flush();
+            auto due = min(lastEdit + saveDebounce, firstUnsaved + kMaxSaveDelay);
+            if (!saveNow && chrono::steady_clock::now() < due) return due;
+            saveQueued = saveNow = false;
+        }
+        flushToDisk();
+        return nullopt;
+    }
+
+    // Folds the journal into a fresh CSV + binary snapshot if anything changed since the
+    // last one (or `always`). The journal is moved aside to .compacting and reopened
+    // empty, and the data copied, under the lock; the writing itself happens outside it
+    // so edits carry on meanwhile. .compacting is only deleted once the new CSVs are in
+    // place, so a crash at any point still replays every edit on the next load. False if
+    // the CSVs or the binary snapshot could not be written (always, for a read-only
+    // tracker); a snapshot that failed stays stale and is tried again on the next save.
+    bool flushToDisk(bool always = false) {
+        if (readOnly) return false;
+        lock_guard<mutex> disk(diskMu);
+        unique_ptr<CycleStore> snapCycles;
+        unique_ptr<LogTable> snapLogs;
+        shared_ptr<const LogSource> source;
+        vector<bool> sourcePaged;
+        uint64_t version;
+        bool csv;
+        const string pending = journalFile + ".compacting";
+        {
+            unique_lock<shared_mutex> lock(mu);
+            journal.flush();
+            csv = always || dataVersion != savedVersion;
+            if (!csv && !binaryStale) return true;
+            if (csv && fileHasData(journalFile)) {
+                journal.close();
+                if (fileHasData(pending)) { if (appendFile(journalFile, pending)) remove(journalFile.c_str()); }
+                else rename(journalFile.c_str(), pending.c_str());
+                if (!journal.open(journalFile))
+                    cerr << RED << "❌ Cannot reopen " << journalFile << "; changes will not be saved." << RESET << "\n";
+            }
+            snapCycles = make_unique<CycleStore>(cycles);
+            snapLogs = make_unique<LogTable>(dailyLogs); // resident blocks only
+            source = logSource;
+            sourcePaged = paged;
+            version = dataVersion;
+        }
+        bool ok = true, binaryOk = false; // ok: the CSVs, when they needed writing
+        if (csv) {
+            ok = saveData(*snapCycles, *snapLogs, source.get(), sourcePaged, binaryOk);
+            if (ok) remove(pending.c_str());
+        } else binaryOk = writeBinarySnapshot(snapshotFile, *snapCycles, *snapLogs, pool, stampOf(cyclesFile), stampOf(logsFile));
+        if (ok && !binaryOk)
+            cerr << YELLOW << "⚠️  Cannot write " << snapshotFile << "; the next load reads the CSV files." << RESET << "\n";
+        unique_lock<shared_mutex> lock(mu);
+        if (ok) {
+            if (csv) savedVersion = version;
+            binaryStale = !binaryOk;
+        }
+        return ok && binaryOk;
+    }
+
+    // Writes a full snapshot (CSVs, then the binary copy stamped with them) via temp files
+    // renamed into place, so readers only ever see a complete old or new file. Log blocks
+    // never paged in (!paged[i] in `src`) are merged in from the old snapshot by block
+    // number, their CSV rows copied as raw bytes. The result is for the CSVs; binaryOk says
+    // whether the binary copy was written too (it is skipped if a value does not fit it).
+    bool saveData(const CycleStore &snapCycles, const LogTable &snapLogs, const LogSource *src, const vector<bool> &paged,
+                  bool &binaryOk) const {
+        PT_TIMED("saveData");
+        const string cyclesTmp = cyclesFile + ".tmp", logsTmp = logsFile + ".tmp";
+        SnapshotWriter snap;
+        FILE *cf = fopen(cyclesTmp.c_str(), "wb");
+        if (!cf) return false;
+        for (const auto &c : snapCycles) { writeCycleRow(cf, c); snap.addCycle(c); }
+        bool ok = fclose(cf) == 0;
+        FILE *lf = fopen(logsTmp.c_str(), "wb");
+        if (!lf) return false;
+        uint32_t next = 0, blocks = src ? src->snap.blockCount() : 0;
+        auto copyBefore = [&](int32_t block) {
+            for (; next < blocks && src->snap.block(next).block < block; ++next)
+                if (!paged[next]) ok = src->copyBlock(next, snap, lf) && ok;
+        };
+        int32_t block = INT32_MIN;
+        snapLogs.forEach([&](Date d, const DailyLog &l) {
+            if (LogTable::blockOf(d) != block) copyBefore(block = LogTable::blockOf(d));
+            snap.addLog(d, pool.str(l.symptoms), pool.str(l.mood), lf);
+            writeLogRow(lf, d, l, pool);
+        });
+        copyBefore(INT32_MAX);
+        snap.endLogs(lf);
+        ok = !ferror(lf) && ok;
+        ok = fclose(lf) == 0 && ok;
+        if (!ok || rename(cyclesTmp.c_str(), cyclesFile.c_str()) != 0 || rename(logsTmp.c_str(), logsFile.c_str()) != 0)
+            return false;
+        binaryOk = snap.write(snapshotFile, stampOf(cyclesFile), stampOf(logsFile));
+        return true;
+    }
+
+    // All mutations of `cycles` go through these helpers so the running stats stay in step.
+    // cycleLength is derived from the preceding start date; inserting or erasing a cycle
+    // only touches the length of its successor, so out-of-order edits need no rescan.
+    void addLength(Date start, int len) {
+        if (len <= 0) return;
+        lengthStats.add(len);
+        if (start >= windowFrom) recentLengths.add(len);
+    }
+
+    void removeLength(Date start, int len) {
+        if (len <= 0) return;
+        lengthStats.remove(len);
+        if (start >= windowFrom) recentLengths.remove(len);
+    }
+
+    // Moves windowFrom forwards or backwards, one cycle at a time, until the window holds
+    // statsWindow lengths (or every length there is).
+    void fitWindow() {
+        while (recentLengths.count() > statsWindow) {
+            CycleEntry first = *cycles.lowerBound(windowFrom);
+            if (first.cycleLength > 0) recentLengths.remove(first.cycleLength);
+            windowFrom = addDays(first.startDate, 1);
+        }
+        while (recentLengths.count() < statsWindow) {
+            auto p = cycles.before(windowFrom);
+            if (!p || p->cycleLength <= 0) break; // only the first cycle has no length
+            recentLengths.add(p->cycleLength);
+            windowFrom = p->startDate;
+        }
+    }
+
+    void setCycleLength(const CycleEntry &c, int len) {
+        if (c.cycleLength == len) return;
+        removeLength(c.startDate, c.cycleLength);
+        addLength(c.startDate, len);
+        cycles.setCycleLength(c.startDate, len);
+    }
+
+    optional<CycleEntry> insertCycle(CycleEntry c) {
+        auto prevCycle = cycles.before(c.startDate);
+        c.cycleLength = prevCycle ? daysBetween(prevCycle->startDate, c.startDate) : 0;
+        if (!cycles.insert(c)) return nullopt;
+        durationStats.add(c.durationDays);
+        addLength(c.startDate, c.cycleLength);
+        if (auto next = cycles.after(c.startDate)) setCycleLength(*next, daysBetween(c.startDate, next->startDate));
+        fitWindow();
+        return cycles.find(c.startDate);
+    }
+
+    void eraseCycle(const CycleEntry &c) {
+        Date start = c.startDate;
+        auto prevCycle = cycles.before(start);
+        if (auto next = cycles.after(start))
+            setCycleLength(*next, prevCycle ? daysBetween(prevCycle->startDate, next->startDate) : 0);
+        durationStats.remove(c.durationDays);
+        removeLength(start, c.cycleLength);
+        cycles.erase(start);
+        fitWindow();
+    }
+
+    // All mutations of `dailyLogs` go through these so the search index stays in step.
+    // Edits page the day's block in first, so it is never overwritten from the snapshot later.
+    void setLog(Date d, const DailyLog &l) {
+        pageIn(d, d);
+        storeLog(d, l);
+    }
+
+    void storeLog(Date d, const DailyLog &l) {
+        DailyLog &slot = dailyLogs[d];
+        logIndex.remove(d, slot);
+        slot = l;
+        logIndex.add(d, slot);
+    }
+
+    void eraseLog(Date d) {
+        if (const DailyLog *l = findLog(d)) {
+            logIndex.remove(d, *l);
+            dailyLogs.erase(d);
+        }
+    }
+
+    // Phase of `d` in the cycle it falls in, with its 1-based cycle day (left untouched
+    // when the day is in no recorded or predicted cycle). Ovulation is taken as 14 days
+    // before the next start, give or take a day.
+    CyclePhase phaseOf(Date d, int &cycleDay) const {
+        auto c = cycles.before(addDays(d, 1));
+        if (!c) return CyclePhase::Any;
+        auto next = cycles.after(c->startDate);
+        Date nextStart = next ? next->startDate : currentPrediction().nextStart;
+        if (!(d < nextStart)) return CyclePhase::Any;
+        cycleDay = daysBetween(c->startDate, d) + 1;
+        int toOvulation = daysBetween(d, addDays(nextStart, -14));
+        if (!(c->endDate < d)) return CyclePhase::Menstrual;
+        if (abs(toOvulation) <= 1) return CyclePhase::Ovulatory;
+        return toOvulation > 0 ? CyclePhase::Follicular : CyclePhase::Luteal;
+    }
+
+    // Walks the shortest posting list inside [from, to] and gallops the others forward;
+    // only surviving days are checked against the cycle filters. Caller holds `mu`.
+    vector<Date> runQuery(const LogQuery &q) const {
+        vector<Date> out;
+        auto cycleMatch = [&](Date d) {
+            if (q.phase == CyclePhase::Any && q.cycleDayFrom == 0) return true;
+            int day = 0;
+            CyclePhase ph = phaseOf(d, day);
+            if (day == 0 || (q.phase != CyclePhase::Any && ph != q.phase)) return false;
+            return q.cycleDayFrom == 0 || (day >= q.cycleDayFrom && day <= q.cycleDayTo);
+        };
+        if (q.terms.empty()) {
+            dailyLogs.forEach(q.from, q.to, [&](Date d, const DailyLog &) { if (cycleMatch(d)) out.push_back(d); });
+            return out;
+        }
+        vector<const vector<int32_t> *> lists;
+        for (const auto &t : q.terms) {
+            const vector<int32_t> *days = logIndex.find(t.first, t.second);
+            if (!days) return out;
+            lists.push_back(days);
+        }
+        sort(lists.begin(), lists.end(), [](auto *a, auto *b) { return a->size() < b->size(); });
+        vector<vector<int32_t>::const_iterator> pos;
+        for (auto *l : lists) pos.push_back(l->begin());
+        auto it = lower_bound(lists[0]->begin(), lists[0]->end(), q.from.days);
+        auto last = upper_bound(it, lists[0]->end(), q.to.days);
+        for (; it != last; ++it) {
+            bool all = true;
+            for (size_t i = 1; i < lists.size() && all; ++i) {
+                pos[i] = lower_bound(pos[i], lists[i]->end(), *it);
+                all = pos[i] != lists[i]->end() && *pos[i] == *it;
+            }
+            if (all && cycleMatch(Date(*it))) out.push_back(Date(*it));
+        }
+        return out;
+    }
+
+    // `header` comes pre-rendered from PT_HEADER.
+    void printHeader(string_view header) const {
+        if (showHeaders) cout.write(header.data(), streamsize(header.size()));
+    }
+
+    void logTableHeader(OutSink &out) const {
+        out.cell("DATE", 12).cell("SYMPTOMS", 40).text("MOOD").endRow();
+        out.text("----------------------------------------------------------------").endRow();
+    }
+
+    void logRow(OutSink &out, Date d, const DailyLog &l) const {
+        out.cell(d, 12).cell(pool.str(l.symptoms), 40).text(pool.str(l.mood)).endRow();
+    }
+
+    void cleanupPastReminders() {
+        Date t = today();
+        manualReminders.dropBefore(t);
+        generatedReminders.dropBefore(t);
+    }
+
+    void publishSummary() {
+        auto s = make_shared<CycleSummary>();
+        s->cycleCount = cycles.size();
+        if (!cycles.empty()) {
+            s->lastStart = cycles.back().startDate;
+            s->durAvg = durationStats.mean(); s->durMedian = durationStats.median();
+            s->durMin = durationStats.min(); s->durMax = durationStats.max();
+        }
+        if ((s->lengthCount = lengthStats.count()) > 0) {
+            s->lenAvg = lengthStats.mean(); s->lenMedian = lengthStats.median(); s->lenStddev = lengthStats.stddev();
+            s->lenMin = lengthStats.min(); s->lenMax = lengthStats.max();
+        }
+        s->windowSize = statsWindow;
+        if ((s->windowCount = recentLengths.count()) > 0) {
+            const WindowedStats &w = recentLengths;
+            s->winMedian = w.median(); s->winTrimmedMean = w.trimmedMean(); s->winMad = w.mad();
+            s->winMin = w.min(); s->winMax = w.max(); s->winTrimmedRange = w.trimmedRange();
+            double reach = std::max(CycleSummary::kOutlierDays, 3 * s->winRobustSd());
+            s->winOutliers = s->windowCount - w.countBetween(s->winMedian - reach, s->winMedian + reach);
+        }
+        atomic_store(&published, shared_ptr<const CycleSummary>(move(s)));
+    }
+
+    void cyclesChanged() {
+        ++cycleVersion;
+        remindersStale = true;
+        publishSummary();
+    }
+
+    // Caller holds `mu`, shared at least.
+    Prediction currentPrediction() const {
+        lock_guard<mutex> g(predictionMu);
+        if (predictionVersion != cycleVersion) {
+            cachedPrediction = Prediction{};
+            if (!cycles.empty()) cachedPrediction = predictor->predict(cycles.back().startDate, LengthHistory(cycles, lengthStats));
+            predictionVersion = cycleVersion;
+        }
+        return cachedPrediction;
+    }
+
+    int typicalDuration() const { return durationStats.count() ? int(lround(durationStats.mean())) : 5; }
+
+    shared_ptr<const Projection> currentProjection() const {
+        Prediction p = currentPrediction();
+        lock_guard<mutex> g(predictionMu);
+        if (projectionVersion != cycleVersion) {
+            cachedProjection = p.valid ? make_shared<const Projection>(p, typicalDuration(), predictor->name()) : nullptr;
+            projectionVersion = cycleVersion;
+        }
+        return cachedProjection;
+    }
+
+    static Date horizonEnd(Date from, int months) { return addDays(from, int(lround(months * 30.44))); }
+
+    static uint64_t nextFeedSerial() {
+        static atomic<uint64_t> next{uint64_t(time(nullptr)) << 16};
+        return next++;
+    }
+
+    string feedVersion(Date day) const {
+        char buf[80];
+        snprintf(buf, sizeof buf, "%llx-%llu.%llu-%d", (unsigned long long)feedSerial, (unsigned long long)cycleVersion,
+                 (unsigned long long)reminderVersion, day.days);
+        return buf;
+    }
+
+    // Caller holds mu exclusively (refreshing the generated reminders may be needed).
+    vector<FeedItem> collectFeedItems(Date now) {
+        if (remindersStale) refreshGeneratedReminders();
+        vector<FeedItem> items;
+        char date[10];
+        for (const ReminderStore *store : {&manualReminders, &generatedReminders})
+            for (const Reminder &r : store->upcoming(store->size())) {
+                if (r.when < now) continue;
+                formatDate(r.when, date);
+                items.push_back({"reminder-" + to_string(r.id) + "-" + string(date, 10) + "@period-tracker", r.message,
+                                 "reminder", r.when, r.when});
+            }
+        if (shared_ptr<const Projection> proj = horizonMonths > 0 ? currentProjection() : nullptr) {
+            static const char *const kinds[] = {"fertile", "pms", "period"};
+            proj->forEach(now, horizonEnd(now, horizonMonths), [&](const ProjectedEvent &e) {
+                if (e.kind == ProjectedKind::Period && e.from == predictedReminderDate && predictedReminderId) return;
+                const char *kind = kinds[int(e.kind)];
+                formatDate(e.from, date);
+                items.push_back({string(kind) + "-" + string(date, 10) + "@period-tracker",
+                                 string(projectedKindName(e.kind)) + " (projected)", kind, e.from, e.to});
+            });
+        }
+        stable_sort(items.begin(), items.end(), [](const FeedItem &a, const FeedItem &b) { return a.from < b.from; });
+        return items;
+    }
+
+    // Only replaces the predicted-period reminder when the prediction actually moved;
+    // manual reminders are kept in their own store and are never rebuilt.
+    void refreshGeneratedReminders() {
+        PT_TIMED("refreshGeneratedReminders");
+        remindersStale = false;
+        Prediction p = currentPrediction();
+        if (!p.valid) {
+            if (predictedReminderId) generatedReminders.remove(predictedReminderId);
+            predictedReminderId = 0;
+            return;
+        }
+        if (predictedReminderId && generatedReminders.contains(predictedReminderId) && p.nextStart == predictedReminderDate)
+            return;
+        if (predictedReminderId) generatedReminders.remove(predictedReminderId);
+        predictedReminderId = nextReminderId++;
+        predictedReminderDate = p.nextStart;
+        generatedReminders.add(predictedReminderId, p.nextStart, "Predicted next period: " + dateToString(p.nextStart));
+    }
+
+    static string dataFile(const string &dir, const char *name) { return dir.empty() ? name : dir + "/" + name; }
+
+    static OpRecord cycleOp(OpKind op, const CycleEntry &c) {
+        return OpRecord{op, c.startDate.days, {c.endDate.days, c.durationDays, c.cycleLength}};
+    }
+
+    // Shared by undo and redo: applies history slot `s` forwards (redo) or backwards (undo).
+    EditResult applyOp(size_t s, bool forward, Date &day) {
+        const OpRecord &r = history.at(s);
+        day = Date(r.day);
+        if (r.op == OpKind::SetLog) {
+            const LogRevision &rev = history.revision(s);
+            if (forward || rev.hadBefore) {
+                const DailyLog &l = forward ? rev.after : rev.before;
+                setLog(day, l);
+                journal.logSet(day, l);
+            } else {
+                eraseLog(day);
+                journal.logRemoved(day);
+            }
+            markDirty();
+            return EditResult::LogChanged;
+        }
+        bool add = (r.op == OpKind::AddCycle) == forward;
+        auto found = cycles.find(day);
+        if (add) {
+            if (found) return EditResult::Conflict;
+            journal.cycleAdded(*insertCycle(CycleEntry(day, Date(r.payload[0]), r.payload[1], r.payload[2])));
+        } else {
+            if (!found || found->endDate.days != r.payload[0]) return EditResult::Conflict;
+            eraseCycle(*found);
+            journal.cycleRemoved(*found);
+        }
+        cyclesChanged();
+        markDirty();
+        return add ? EditResult::Restored : EditResult::Removed;
+    }
 
-// (All structures and functions are the same as your version; only main/menu flushing/tie changed)
+public:
+    // dataDir empty = current directory (cycles.csv, daily_logs.csv, tracker.journal).
+    explicit PeriodTracker(const string &dataDir = "", const TrackerOptions &opts = TrackerOptions())
+        : history(opts.undoDepth), predictor(opts.predictor), horizonMonths(opts.horizonMonths), feedSerial(nextFeedSerial()), cyclesFile(dataFile(dataDir, "cycles.csv")), logsFile(dataFile(dataDir, "daily_logs.csv")),
+          journalFile(dataFile(dataDir, "tracker.journal")), snapshotFile(dataFile(dataDir, "tracker.snap")),
+          statsWindow(std::clamp<size_t>(opts.statsWindow, 1, WindowedStats::kMaxWindow)), saveDebounce(opts.saveDebounce), readOnly(opts.readOnly) {
+        loadData();
+        if (!readOnly && (savedVersion != dataVersion || binaryStale)) { // journal to fold or snapshot to build
+            saveQueued = saveNow = true;
+            BackgroundSaver::global().schedule(this, chrono::steady_clock::now());
+        }
+    }
+    // Anything still unsaved is written out here rather than left to the next load.
+    ~PeriodTracker() {
+        BackgroundSaver::global().cancel(this);
+        flushToDisk();
+    }
 
-struct CycleEntry {
-    string startDate;
-    string endDate;
-    int durationDays = 0;
-    int cycleLength = 0;
-    CycleEntry() = default;
-    CycleEntry(string s, string e, int d, int c)
-        : startDate(move(s)), endDate(move(e)), durationDays(d), cycleLength(c) {}
-};
+    // Batch mode drops the decorated headers and stops flushing the journal per record;
+    // save() then flushes everything once.
+    void setBatchMode(bool on) {
+        PT_TIMED("setBatchMode");
+        unique_lock<shared_mutex> lock(mu);
+        showHeaders = !on;
+        journal.setAutoFlush(!on);
+    }
 
-struct DailyLog { string date, symptoms, mood; };
+    void setPageRows(size_t rows) {
+        PT_TIMED("setPageRows");
+        unique_lock<shared_mutex> lock(mu);
+        pageRows = rows;
+    }
 
-struct Reminder {
-    sys_time when;
-    string message;
-    
-    bool operator==(const Reminder &o) const { return when == o.when && message == o.message; }
-};
+    shared_ptr<const CycleSummary> summary() const { return atomic_load(&published); }
 
-struct CompareReminder {
-    bool operator()(const Reminder &a, const Reminder &b) const { return a.when > b.when; }
-};
+    Prediction prediction() const {
+        PT_TIMED("prediction");
+        shared_lock<shared_mutex> lock(mu);
+        return currentPrediction();
+    }
 
-// trim helper
-static inline string trim(const string &s) {
-    size_t a = 0, b = s.size();
-    while (a < b && isspace((unsigned char)s[a])) ++a;
-    while (b > a && isspace((unsigned char)s[b-1])) --b;
-    return s.substr(a, b - a);
-}
+    void setPredictor(shared_ptr<const Predictor> p) {
+        PT_TIMED("setPredictor");
+        unique_lock<shared_mutex> lock(mu);
+        predictor = move(p);
+        ++cycleVersion;
+        remindersStale = true;
+    }
 
-bool parseDate(const string &in, tm &out_tm) {
-    out_tm = tm{};
-    istringstream ss(in);
-    ss >> get_time(&out_tm, "%Y-%m-%d");
-    return !ss.fail();
-}
+    // The projected schedule for the current data, cached until the next cycle edit or
+    // predictor change; nullptr until a cycle is recorded.
+    shared_ptr<const Projection> projection() const {
+        PT_TIMED("projection");
+        shared_lock<shared_mutex> lock(mu);
+        return currentProjection();
+    }
 
-bool stringToTimePoint(const string &s, sys_time &tp) {
-    tm tm_ = {};
-    if (!parseDate(s, tm_)) return false;
-    tm_.tm_hour = tm_.tm_min = tm_.tm_sec = 0;
-    time_t tt = mktime(&tm_);
-    if (tt == -1) return false;
-    tp = chrono::system_clock::from_time_t(tt);
-    return true;
-}
+    // What-if: the schedule another model would project from the same history. Not cached,
+    // and the tracker's own predictor is left alone.
+    shared_ptr<const Projection> projectionWith(const Predictor &model) const {
+        PT_TIMED("projectionWith");
+        shared_lock<shared_mutex> lock(mu);
+        if (cycles.empty()) return nullptr;
+        Prediction p = model.predict(cycles.back().startDate, LengthHistory(cycles, lengthStats));
+        return make_shared<const Projection>(p, typicalDuration(), model.name());
+    }
 
-string timePointToString(const sys_time &tp) {
-    time_t tt = chrono::system_clock::to_time_t(tp);
-    tm buf = *localtime(&tt);
-    ostringstream os;
-    os << put_time(&buf, "%Y-%m-%d");
-    return os.str();
-}
+    int horizon() const { return horizonMonths; }
 
-int daysBetween(const string &d1, const string &d2) {
-    sys_time t1, t2;
-    if (!stringToTimePoint(d1, t1) || !stringToTimePoint(d2, t2)) return 0;
-    time_t tt1 = chrono::system_clock::to_time_t(t1);
-    time_t tt2 = chrono::system_clock::to_time_t(t2);
-    long long secs = static_cast<long long>(tt2) - static_cast<long long>(tt1);
-    return static_cast<int>(secs / (24LL * 3600LL));
-}
+    // The current calendar feed. Polls while nothing has changed take the shared lock
+    // only long enough to compare versions.
+    shared_ptr<const Feed> feed() {
+        PT_TIMED("feed");
+        Date now = today();
+        {
+            shared_lock<shared_mutex> lock(mu);
+            string v = feedVersion(now);
+            lock_guard<mutex> g(feedMu);
+            if (cachedFeed && cachedFeed->version == v) return cachedFeed;
+        }
+        unique_lock<shared_mutex> lock(mu);
+        vector<FeedItem> items = collectFeedItems(now);
+        string v = feedVersion(now);
+        lock_guard<mutex> g(feedMu);
+        if (cachedFeed && cachedFeed->version == v) return cachedFeed; // built while we waited
+        if (cachedFeed) {
+            feedHistory.push_back(cachedFeed);
+            if (feedHistory.size() > kFeedHistory) feedHistory.pop_front();
+        }
+        cachedFeed = buildFeed(move(v), move(items), now);
+        return cachedFeed;
+    }
 
-string addDays(const string &dateStr, int days) {
-    sys_time t;
-    if (!stringToTimePoint(dateStr, t)) return "";
-    t += chrono::seconds(24LL * 3600LL * days);
-    return timePointToString(t);
-}
+    // The response taking a client from version `since` to `current`, or nullopt when
+    // `since` is too old (or unknown) and the client needs the full feed.
+    optional<string> feedDelta(const shared_ptr<const Feed> &current, string_view since) {
+        PT_TIMED("feedDelta");
+        if (since == current->version) return current->notModified;
+        {
+            lock_guard<mutex> g(current->deltaMu);
+            auto it = current->deltas.find(string(since));
+            if (it != current->deltas.end()) return it->second;
+        }
+        shared_ptr<const Feed> old;
+        {
+            lock_guard<mutex> g(feedMu);
+            for (const auto &f : feedHistory) if (f->version == since) old = f;
+        }
+        if (!old) return nullopt;
+        string r = ::feedDelta(*old, *current);
+        lock_guard<mutex> g(current->deltaMu);
+        return current->deltas.emplace(string(since), move(r)).first->second;
+    }
 
-int daysFromTodayTo(const string &dateStr) {
-    sys_time now = chrono::system_clock::now();
-    sys_time target;
-    if (!stringToTimePoint(dateStr, target)) return 0;
-    time_t ttNow = chrono::system_clock::to_time_t(now);
-    time_t ttT = chrono::system_clock::to_time_t(target);
-    long long secs = static_cast<long long>(ttT) - static_cast<long long>(ttNow);
-    return static_cast<int>(secs / (24LL * 3600LL));
-}
+    const char *predictorName() const {
+        PT_TIMED("predictorName");
+        shared_lock<shared_mutex> lock(mu);
+        return predictor->name();
+    }
 
-// ---------- PeriodTracker (identical to your previous fixed version) ----------
-class PeriodTracker {
-private:
-    vector<CycleEntry> cycles;
-    map<string, DailyLog> dailyLogs;
-    stack<CycleEntry> undoStack;
-    stack<CycleEntry> redoStack;
-    priority_queue<Reminder, vector<Reminder>, CompareReminder> reminders;
-    const string cyclesFile = "cycles.csv";
-    const string logsFile = "daily_logs.csv";
+    // Adds this user's cycles to a population accumulator.
+    void accumulate(PopulationStats &out) const {
+        PT_TIMED("accumulate");
+        shared_lock<shared_mutex> lock(mu);
+        ++out.users;
+        ColumnStats len = cycles.lengthStats();
+        out.cycles += cycles.size();
+        out.lengthCount += len.count;
+        out.lengthSum += uint64_t(len.sum);
+        cycles.forEachRow([&](int duration, int length) { out.addHistogram(duration, length); });
+        auto sum = summary();
+        if (sum->lengthCount > 0) ++out.usersWithLengths;
+        if (isIrregular(*sum)) ++out.irregularUsers;
+    }
 
-    void loadData() {
-        ifstream cf(cyclesFile);
-        if (cf.is_open()) {
-            string line;
-            while (getline(cf, line)) {
-                line = trim(line);
-                if (line.empty()) continue;
-                vector<string> parts;
-                string cur;
-                istringstream ss(line);
-                while (getline(ss, cur, ',')) parts.push_back(trim(cur));
-                if (parts.size() >= 4) {
-                    try {
-                        int d = stoi(parts[2]);
-                        int c = stoi(parts[3]);
-                        cycles.emplace_back(parts[0], parts[1], d, c);
-                    } catch (...) { continue; }
+    // ---- core operations (no console I/O) ----
+    EditResult addCycle(Date start, Date end) {
+        PT_TIMED("addCycle");
+        unique_lock<shared_mutex> lock(mu);
+        int duration = daysBetween(start, end);
+        if (duration < 0) return EditResult::EndBeforeStart;
+        if (cycles.find(start)) return EditResult::Duplicate;
+        CycleEntry e = *insertCycle(CycleEntry(start, end, duration, 0));
+        journal.cycleAdded(e);
+        history.push(cycleOp(OpKind::AddCycle, e));
+        cyclesChanged();
+        markDirty();
+        return EditResult::Ok;
+    }
+
+    EditResult deleteCycle(Date start) {
+        PT_TIMED("deleteCycle");
+        unique_lock<shared_mutex> lock(mu);
+        auto found = cycles.find(start);
+        if (!found) return EditResult::NotFound;
+        CycleEntry removed = *found; eraseCycle(removed);
+        journal.cycleRemoved(removed);
+        history.push(cycleOp(OpKind::RemoveCycle, removed));
+        cyclesChanged();
+        markDirty();
+        return EditResult::Ok;
+    }
+
+    // `day` is set to the cycle start or log date the undone / redone edit touched.
+    EditResult undoLast(Date &day) {
+        PT_TIMED("undoLast");
+        unique_lock<shared_mutex> lock(mu);
+        auto s = history.nextUndo();
+        if (!s) return EditResult::Nothing;
+        EditResult r = applyOp(*s, false, day);
+        if (r != EditResult::Conflict) history.undone();
+        return r;
+    }
+
+    EditResult redoLast(Date &day) {
+        PT_TIMED("redoLast");
+        unique_lock<shared_mutex> lock(mu);
+        auto s = history.nextRedo();
+        if (!s) return EditResult::Nothing;
+        EditResult r = applyOp(*s, true, day);
+        if (r != EditResult::Conflict) history.redone();
+        return r;
+    }
+
+    // Symptoms are appended to an existing entry for the day; a non-empty mood replaces it.
+    void logDaily(Date date, const string &symptoms, const string &mood) {
+        PT_TIMED("logDaily");
+        unique_lock<shared_mutex> lock(mu);
+        LogRevision &rev = history.revision(history.push(OpRecord{OpKind::SetLog, date.days, {}}));
+        const DailyLog *prev = findLog(date);
+        if ((rev.hadBefore = prev != nullptr)) rev.before = *prev;
+        DailyLog log = rev.before;
+        if (!symptoms.empty()) {
+            string_view old = pool.str(log.symptoms);
+            log.symptoms = pool.intern(old.empty() ? symptoms : string(old) + "; " + symptoms);
+        }
+        if (!mood.empty()) log.mood = pool.intern(mood);
+        rev.after = log;
+        setLog(date, log);
+        journal.logSet(date, log);
+        markDirty();
+    }
+
+    uint32_t addReminder(Date when, string message) {
+        PT_TIMED("addReminder");
+        unique_lock<shared_mutex> lock(mu);
+        uint32_t id = nextReminderId++;
+        manualReminders.add(id, when, move(message));
+        ++reminderVersion;
+        return id;
+    }
+
+    EditResult removeReminder(uint32_t id) {
+        PT_TIMED("removeReminder");
+        unique_lock<shared_mutex> lock(mu);
+        if (remindersStale) refreshGeneratedReminders();
+        if (generatedReminders.contains(id)) return EditResult::Conflict;
+        if (!manualReminders.remove(id)) return EditResult::NotFound;
+        ++reminderVersion;
+        return EditResult::Ok;
+    }
+
+    // Rough resident size, from entry counts only so it is O(1) to ask.
+    size_t approxBytes() const {
+        PT_TIMED("approxBytes");
+        shared_lock<shared_mutex> lock(mu);
+        const size_t perCycle = sizeof(CycleEntry) + 1 + 48 + 2 * 40; // slot + index node + stats nodes
+        return sizeof(*this) + cycles.size() * perCycle + dailyLogs.bytes() + pool.bytes()
+             + (manualReminders.size() + generatedReminders.size()) * (sizeof(Reminder) + 40);
+    }
+
+    // Streams an interchange file (see "Streaming import / export") into this tracker
+    // through three threads joined by bounded queues: the first reads 1 MiB blocks and
+    // splits them into rows, the second validates them, converts dates and interns the
+    // text, and the calling thread merges each chunk under a single lock. Memory stays
+    // at a few chunks whatever the file size. Cycles already recorded, and logs identical
+    // to the stored one, are counted as duplicates; other logs replace the day's entry.
+    // Imported records are journaled like edits but are not undoable. nullopt if the file
+    // cannot be opened.
+    optional<ImportResult> importFile(const string &path, StreamFormat fmt) {
+        PT_TIMED("importFile");
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp) return nullopt;
+        constexpr size_t kBlock = 1 << 20, kDepth = 4;
+        BoundedQueue<ImportChunk> parsed(kDepth);
+        BoundedQueue<vector<ImportRecord>> validated(kDepth);
+        ImportResult res;
+
+        thread reader([&] {
+            string carry;
+            size_t lineNo = 0;
+            for (bool eof = false; !eof;) {
+                ImportChunk chunk;
+                chunk.text = move(carry);
+                size_t have = chunk.text.size();
+                chunk.text.resize(have + kBlock);
+                size_t got = fread(chunk.text.data() + have, 1, kBlock, fp);
+                chunk.text.resize(have + got);
+                eof = got == 0;
+                if (!eof) {
+                    size_t cut = chunk.text.rfind('\n');
+                    if (cut == string::npos || cut < have) { carry = move(chunk.text); continue; } // line spans blocks
+                    carry.assign(chunk.text, cut + 1, string::npos);
+                    chunk.text.resize(cut + 1);
                 }
+                parseImportChunk(chunk, fmt, lineNo);
+                if (!chunk.rows.empty() && !parsed.push(move(chunk))) break;
             }
-        }
-        ifstream lf(logsFile);
-        if (lf.is_open()) {
-            string line;
-            while (getline(lf, line)) {
-                line = trim(line);
-                if (line.empty()) continue;
-                vector<string> parts;
-                string cur;
-                istringstream ss(line);
-                while (getline(ss, cur, ',')) parts.push_back(trim(cur));
-                if (parts.size() >= 3) {
-                    dailyLogs[parts[0]] = {parts[0], parts[1], parts[2]};
+            parsed.close();
+        });
+
+        thread validator([&] {
+            while (optional<ImportChunk> chunk = parsed.pop()) {
+                vector<ImportRecord> out;
+                out.reserve(chunk->rows.size());
+                for (const ImportRow &r : chunk->rows) {
+                    ImportRecord rec{r.cycle, Date(), Date(), DailyLog{}};
+                    const char *why = r.error;
+                    if (!why && !parseDate(chunk->field(r, 0), rec.first)) why = "invalid date";
+                    else if (!why && r.cycle && !parseDate(chunk->field(r, 1), rec.second)) why = "invalid end date";
+                    else if (!why && r.cycle && rec.second < rec.first) why = "end date before start date";
+                    if (why) { reportBadRow(path, r.line, why); ++res.rejected; continue; }
+                    if (!r.cycle) rec.log = DailyLog{pool.intern(cleanText(chunk->field(r, 1))), pool.intern(cleanText(chunk->field(r, 2)))};
+                    out.push_back(rec);
                 }
+                if (!validated.push(move(out))) break;
             }
-        }
-        rebuildRemindersFromCycles();
-    }
+            validated.close();
+        });
 
-    void saveData() const {
-        ofstream cf(cyclesFile, ios::trunc);
-        for (const auto &c : cycles)
-            cf << c.startDate << "," << c.endDate << "," << c.durationDays << "," << c.cycleLength << "\n";
-        ofstream lf(logsFile, ios::trunc);
-        for (const auto &p : dailyLogs) {
-            string safeSymptoms = p.second.symptoms; replace(safeSymptoms.begin(), safeSymptoms.end(), ',', ';');
-            string safeMood = p.second.mood; replace(safeMood.begin(), safeMood.end(), ',', ';');
-            lf << p.first << "," << safeSymptoms << "," << safeMood << "\n";
+        while (optional<vector<ImportRecord>> batch = validated.pop()) {
+            unique_lock<shared_mutex> lock(mu);
+            bool flushing = journal.autoFlushing(), cyclesTouched = false;
+            journal.setAutoFlush(false);
+            for (const ImportRecord &rec : *batch) {
+                if (rec.cycle) {
+                    if (cycles.find(rec.first)) { ++res.duplicates; continue; }
+                    journal.cycleAdded(*insertCycle(CycleEntry(rec.first, rec.second, daysBetween(rec.first, rec.second), 0)));
+                    cyclesTouched = true;
+                    ++res.cycles;
+                } else {
+                    const DailyLog *cur = findLog(rec.first);
+                    if (cur && cur->symptoms == rec.log.symptoms && cur->mood == rec.log.mood) { ++res.duplicates; continue; }
+                    setLog(rec.first, rec.log);
+                    journal.logSet(rec.first, rec.log);
+                    ++res.logs;
+                }
+            }
+            journal.setAutoFlush(flushing);
+            if (cyclesTouched) cyclesChanged();
+            if (!batch->empty()) markDirty();
         }
+        reader.join();
+        validator.join();
+        fclose(fp);
+        return res;
     }
 
-    int averageCycleLength() const {
-        int sum = 0, cnt = 0;
-        for (const auto &c : cycles) if (c.cycleLength > 0) { sum += c.cycleLength; ++cnt; }
-        return (cnt > 0) ? (sum / cnt) : 28;
-    }
+    // Writes every cycle and log, merged in date order, through three stages: this
+    // tracker is read in windows of kWindowDays under a shared lock (so edits are only
+    // held off briefly; each window is consistent on its own), a second thread formats
+    // each window, and a third writes it out while the next is being read and formatted.
+    bool exportFile(const string &path, StreamFormat fmt) {
+        PT_TIMED("exportFile");
+        ensurePaged(Date(INT32_MIN), Date(INT32_MAX));
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (!fp) return false;
+        constexpr int32_t kWindowDays = 4096;
+        constexpr size_t kDepth = 4;
+        struct Window {
+            vector<CycleEntry> cycles;
+            vector<pair<Date, DailyLog>> logs;
+        };
+        BoundedQueue<Window> windows(kDepth);
+        BoundedQueue<string> blocks(kDepth);
+        bool ok = true;
 
-    void printHeader(const string &title) const {
-        cout << BOLD << CYAN << "\n╔════════════════════════════════════════════════════════╗\n";
-        cout << "  " << title << "\n";
-        cout << "╚════════════════════════════════════════════════════════╝\n" << RESET;
-    }
+        thread formatter([&] {
+            while (optional<Window> w = windows.pop()) {
+                string out;
+                out.reserve((w->cycles.size() + w->logs.size()) * 48);
+                size_t c = 0;
+                for (const auto &l : w->logs) {
+                    for (; c < w->cycles.size() && w->cycles[c].startDate <= l.first; ++c) appendCycleRecord(out, w->cycles[c], fmt);
+                    appendLogRecord(out, l.first, l.second, pool, fmt);
+                }
+                for (; c < w->cycles.size(); ++c) appendCycleRecord(out, w->cycles[c], fmt);
+                if (!blocks.push(move(out))) break;
+            }
+            blocks.close();
+        });
 
-    void pushReminder(const Reminder &r) { reminders.push(r); }
+        thread writer([&] {
+            while (optional<string> b = blocks.pop())
+                if (ok && fwrite(b->data(), 1, b->size(), fp) != b->size()) ok = false;
+        });
 
-    void cleanupPastReminders() {
-        while (!reminders.empty()) {
-            Reminder top = reminders.top();
-            if (top.when < chrono::system_clock::now()) reminders.pop();
-            else break;
+        optional<Date> from, last;
+        {
+            shared_lock<shared_mutex> lock(mu);
+            if (!cycles.empty()) { from = (*cycles.begin()).startDate; last = cycles.back().startDate; }
+            if (!dailyLogs.empty()) {
+                auto span = dailyLogs.span();
+                from = from ? min(*from, span.first) : span.first;
+                last = last ? max(*last, span.second) : span.second;
+            }
+        }
+        for (int64_t lo = from ? from->days : 1, hi = last ? last->days : 0; lo <= hi; lo += kWindowDays) {
+            Date a = Date(int32_t(lo)), b = Date(int32_t(min<int64_t>(hi, lo + kWindowDays - 1)));
+            Window w;
+            {
+                shared_lock<shared_mutex> lock(mu);
+                for (auto it = cycles.lowerBound(a); it != cycles.end() && (*it).startDate <= b; ++it) w.cycles.push_back(*it);
+                dailyLogs.forEach(a, b, [&](Date d, const DailyLog &l) { w.logs.emplace_back(d, l); });
+            }
+            if ((!w.cycles.empty() || !w.logs.empty()) && !windows.push(move(w))) break;
         }
+        windows.close();
+        formatter.join();
+        writer.join();
+        return fclose(fp) == 0 && ok;
     }
 
-public:
-    PeriodTracker() { loadData(); }
-    ~PeriodTracker() {}
+    // Writes the CSV and binary snapshots now, on the calling thread, changed or not.
+    bool writeSnapshot() {
+        PT_TIMED("writeSnapshot");
+        return flushToDisk(true);
+    }
+
+    // Makes every edit so far durable (journal flushed) and, if there are unsaved edits,
+    // asks the saver to fold them into the snapshot without waiting for the debounce.
+    void save() {
+        PT_TIMED("save");
+        unique_lock<shared_mutex> lock(mu);
+        journal.flush();
+        if (!saveQueued) return;
+        saveNow = true;
+        BackgroundSaver::global().schedule(this, chrono::steady_clock::now());
+    }
 
+    // ---- interactive front-ends ----
     void addCycleFromUser() {
-        printHeader("✨ ADD NEW CYCLE ENTRY ✨");
-        string start, end;
+        printHeader(PT_HEADER("✨ ADD NEW CYCLE ENTRY ✨"));
+        string startStr, endStr;
         cout << "Enter START date (YYYY-MM-DD): ";
-        cin >> start;
+        cin >> startStr;
         cout << "Enter END date (YYYY-MM-DD): ";
-        cin >> end;
-        tm tm1 = {}, tm2 = {};
-        if (!parseDate(start, tm1) || !parseDate(end, tm2)) {
-            cout << RED << "❌ Invalid date format. Use YYYY-MM-DD." << RESET << "\n";
+        cin >> endStr;
+        Date start, end;
+        if (!parseDate(startStr, start) || !parseDate(endStr, end)) {
+            cout << PT_LINE(Red, "❌ Invalid date format. Use YYYY-MM-DD.");
             return;
         }
-        int duration = daysBetween(start, end);
-        if (duration < 0) {
-            cout << RED << "❌ End date must be after start date." << RESET << "\n";
-            return;
+        switch (addCycle(start, end)) {
+            case EditResult::EndBeforeStart: cout << PT_LINE(Red, "❌ End date must be after start date."); return;
+            case EditResult::Duplicate: cout << RED << "❌ A cycle starting " << start << " is already recorded." << RESET << "\n"; return;
+            default: break;
         }
-        int cycleLen = 0;
-        if (!cycles.empty()) cycleLen = daysBetween(cycles.back().startDate, start);
-        CycleEntry e(start, end, duration, cycleLen);
-        cycles.push_back(e);
-        undoStack.push(e);
-        while (!redoStack.empty()) redoStack.pop();
         cout << GREEN << "✅ Cycle recorded: " << start << " -> " << end << RESET << "\n";
-        cout << YELLOW << "Duration: " << duration << " days" << RESET << "\n";
-        rebuildRemindersFromCycles();
+        cout << YELLOW << "Duration: " << daysBetween(start, end) << " days" << RESET << "\n";
     }
 
     void deleteCycleByStart() {
-        printHeader("🗑️ DELETE CYCLE ENTRY (by START date) 🗑️");
-        if (cycles.empty()) { cout << YELLOW << "No cycles to delete." << RESET << "\n"; return; }
-        string target; cout << "Enter START date of cycle to delete (YYYY-MM-DD): "; cin >> target;
-        auto it = find_if(cycles.begin(), cycles.end(), [&](const CycleEntry &c){ return c.startDate == target; });
-        if (it == cycles.end()) { cout << RED << "Not found." << RESET << "\n"; return; }
-        CycleEntry removed = *it; cycles.erase(it);
-        undoStack.push(removed); while (!redoStack.empty()) redoStack.pop();
-        cout << GREEN << "✅ Deleted cycle starting " << removed.startDate << RESET << "\n";
-        rebuildRemindersFromCycles();
+        printHeader(PT_HEADER("🗑️ DELETE CYCLE ENTRY (by START date) 🗑️"));
+        if (summary()->cycleCount == 0) { cout << PT_LINE(Yellow, "No cycles to delete."); return; }
+        string targetStr; cout << "Enter START date of cycle to delete (YYYY-MM-DD): "; cin >> targetStr;
+        Date target;
+        if (!parseDate(targetStr, target)) { cout << PT_LINE(Red, "Invalid date format."); return; }
+        if (deleteCycle(target) == EditResult::NotFound) { cout << PT_LINE(Red, "Not found."); return; }
+        cout << GREEN << "✅ Deleted cycle starting " << target << RESET << "\n";
     }
 
     void undo() {
-        printHeader("↶ UNDO (last cycle action)");
-        if (undoStack.empty()) { cout << YELLOW << "Nothing to undo." << RESET << "\n"; return; }
-        CycleEntry top = undoStack.top(); undoStack.pop();
-        auto it = find_if(cycles.begin(), cycles.end(), [&](const CycleEntry &c){
-            return c.startDate == top.startDate && c.endDate == top.endDate;
-        });
-        if (it != cycles.end()) {
-            cycles.erase(it);
-            cout << GREEN << "Undo: removed cycle starting " << top.startDate << RESET << "\n";
-            redoStack.push(top);
-        } else {
-            cycles.push_back(top);
-            cout << GREEN << "Undo: restored cycle starting " << top.startDate << RESET << "\n";
-            redoStack.push(top);
+        printHeader(PT_HEADER("↶ UNDO (last edit)"));
+        Date d;
+        switch (undoLast(d)) {
+            case EditResult::Nothing: cout << PT_LINE(Yellow, "Nothing to undo."); break;
+            case EditResult::Removed: cout << GREEN << "Undo: removed cycle starting " << d << RESET << "\n"; break;
+            case EditResult::Restored: cout << GREEN << "Undo: restored cycle starting " << d << RESET << "\n"; break;
+            case EditResult::LogChanged: cout << GREEN << "Undo: reverted daily log for " << d << RESET << "\n"; break;
+            default: cout << RED << "Undo: a different cycle starting " << d << " is recorded; skipped." << RESET << "\n";
         }
-        rebuildRemindersFromCycles();
     }
 
     void redo() {
-        printHeader("↷ REDO (re-apply last undone)");
-        if (redoStack.empty()) { cout << YELLOW << "Nothing to redo." << RESET << "\n"; return; }
-        CycleEntry top = redoStack.top(); redoStack.pop();
-        auto it = find_if(cycles.begin(), cycles.end(), [&](const CycleEntry &c){
-            return c.startDate == top.startDate && c.endDate == top.endDate;
-        });
-        if (it != cycles.end()) {
-            cycles.erase(it);
-            cout << GREEN << "Redo: removed cycle starting " << top.startDate << RESET << "\n";
-            undoStack.push(top);
-        } else {
-            cycles.push_back(top);
-            cout << GREEN << "Redo: restored cycle starting " << top.startDate << RESET << "\n";
-            undoStack.push(top);
+        printHeader(PT_HEADER("↷ REDO (re-apply last undone)"));
+        Date d;
+        switch (redoLast(d)) {
+            case EditResult::Nothing: cout << PT_LINE(Yellow, "Nothing to redo."); break;
+            case EditResult::Removed: cout << GREEN << "Redo: removed cycle starting " << d << RESET << "\n"; break;
+            case EditResult::Restored: cout << GREEN << "Redo: restored cycle starting " << d << RESET << "\n"; break;
+            case EditResult::LogChanged: cout << GREEN << "Redo: re-applied daily log for " << d << RESET << "\n"; break;
+            default: cout << RED << "Redo: a different cycle starting " << d << " is recorded; skipped." << RESET << "\n";
         }
-        rebuildRemindersFromCycles();
     }
 
     void logDailySymptomFromUser() {
-        printHeader("📝 LOG DAILY SYMPTOM & MOOD 📝");
-        string date; cout << "Enter DATE (YYYY-MM-DD): "; cin >> date;
+        printHeader(PT_HEADER("📝 LOG DAILY SYMPTOM & MOOD 📝"));
+        string dateStr; cout << "Enter DATE (YYYY-MM-DD): "; cin >> dateStr;
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        Date date;
+        if (!parseDate(dateStr, date)) { cout << PT_LINE(Red, "Invalid date format."); return; }
         string symptoms, mood;
         cout << "Enter SYMPTOMS: "; getline(cin, symptoms);
         cout << "Enter MOOD: "; getline(cin, mood);
-        if (dailyLogs.count(date)) {
-            if (!symptoms.empty()) {
-                if (!dailyLogs[date].symptoms.empty()) dailyLogs[date].symptoms += "; ";
-                dailyLogs[date].symptoms += symptoms;
-            }
-            if (!mood.empty()) dailyLogs[date].mood = mood;
-        } else dailyLogs[date] = {date, symptoms, mood};
+        logDaily(date, symptoms, mood);
         cout << GREEN << "✅ Logged for " << date << RESET << "\n";
     }
 
+    // The listings copy their rows out under the shared lock and print them after it is
+    // released: a reader paused at the pager must not hold up the saver or other writers.
     void displayCycles() const {
-        printHeader("🩸 MENSTRUAL CYCLE HISTORY 🩸");
-        if (cycles.empty()) { cout << YELLOW << "No cycles recorded yet." << RESET << "\n"; return; }
-        cout << left << BOLD;
-        cout << setw(12) << "START" << setw(12) << "END" << setw(8) << "DAYS" << setw(12) << "CYCLE_LEN" << "\n" << RESET;
-        cout << "------------------------------------------------\n";
-        for (const auto &c : cycles) {
-            cout << setw(12) << c.startDate << setw(12) << c.endDate << setw(8) << c.durationDays
-                 << setw(12) << (c.cycleLength > 0 ? to_string(c.cycleLength) : "N/A") << "\n";
+        PT_TIMED("displayCycles");
+        printHeader(PT_HEADER("🩸 MENSTRUAL CYCLE HISTORY 🩸"));
+        vector<CycleEntry> rows;
+        {
+            shared_lock<shared_mutex> lock(mu);
+            rows.reserve(cycles.size());
+            for (const CycleEntry &c : cycles) rows.push_back(c);
+        }
+        if (rows.empty()) { cout << PT_LINE(Yellow, "No cycles recorded yet."); return; }
+        OutSink out(cout, pageRows);
+        out.text(BOLD).cell("START", 12).cell("END", 12).cell("DAYS", 8).cell("CYCLE_LEN", 12).endRow();
+        out.text(RESET).text("------------------------------------------------").endRow();
+        for (size_t i = 0; i < rows.size() && !out.done(); ++i) {
+            const CycleEntry &c = rows[i];
+            out.cell(c.startDate, 12).cell(c.endDate, 12).cell(c.durationDays, 8);
+            if (c.cycleLength > 0) out.cell(c.cycleLength, 12); else out.cell("N/A", 12);
+            out.endRow();
+        }
+    }
+
+    void displayDailyLogs() {
+        PT_TIMED("displayDailyLogs");
+        printHeader(PT_HEADER("📈 DAILY SYMPTOM LOGS & MOOD 📊"));
+        ensurePaged(Date(INT32_MIN), Date(INT32_MAX));
+        vector<pair<Date, DailyLog>> rows;
+        {
+            shared_lock<shared_mutex> lock(mu);
+            rows.reserve(dailyLogs.size());
+            dailyLogs.forEach([&](Date d, const DailyLog &l) { rows.emplace_back(d, l); });
+        }
+        if (rows.empty()) { cout << PT_LINE(Yellow, "No logs yet."); return; }
+        OutSink out(cout, pageRows);
+        logTableHeader(out);
+        for (size_t i = 0; i < rows.size() && !out.done(); ++i) logRow(out, rows[i].first, rows[i].second);
+    }
+
+    vector<Date> queryLogs(const LogQuery &q) {
+        PT_TIMED("queryLogs");
+        ensurePaged(q.from, q.to);
+        shared_lock<shared_mutex> lock(mu);
+        return runQuery(q);
+    }
+
+    void showLogQuery(const LogQuery &q) {
+        PT_TIMED("showLogQuery");
+        printHeader(PT_HEADER("🔍 DAILY LOG SEARCH 🔍"));
+        ensurePaged(q.from, q.to);
+        vector<Date> days;
+        vector<DailyLog> logs;
+        {
+            shared_lock<shared_mutex> lock(mu);
+            days = runQuery(q);
+            logs.reserve(days.size());
+            for (Date d : days) logs.push_back(*dailyLogs.find(d));
         }
+        OutSink out(cout, pageRows);
+        out.text(CYAN).num((long long)days.size()).text(" matching day(s)").text(RESET).endRow();
+        if (days.empty()) return;
+        logTableHeader(out);
+        map<uint32_t, size_t> moods;
+        for (size_t i = 0; i < days.size() && !out.done(); ++i) {
+            const DailyLog &l = logs[i];
+            logRow(out, days[i], l);
+            if (l.mood) ++moods[l.mood];
+        }
+        if (moods.empty() || out.done()) return;
+        vector<pair<size_t, uint32_t>> byCount;
+        for (const auto &m : moods) byCount.emplace_back(m.second, m.first);
+        sort(byCount.begin(), byCount.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+        out.text(YELLOW).text("Moods:");
+        for (const auto &m : byCount) out.text(" ").text(pool.str(m.second)).text(" x").num((long long)m.first);
+        out.text(RESET).endRow();
     }
 
-    void displayDailyLogs() const {
-        printHeader("📈 DAILY SYMPTOM LOGS & MOOD 📊");
-        if (dailyLogs.empty()) { cout << YELLOW << "No logs yet." << RESET << "\n"; return; }
-        cout << left << setw(12) << "DATE" << setw(40) << "SYMPTOMS" << "MOOD\n";
-        cout << "----------------------------------------------------------------\n";
-        for (const auto &p : dailyLogs)
-            cout << setw(12) << p.first << setw(40) << p.second.symptoms << p.second.mood << "\n";
+    void searchLogsFromUser() {
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        string text;
+        cout << "Search (e.g. headache mood:tired phase:luteal from:2024-01-01 day:1-5): ";
+        getline(cin, text);
+        LogQuery q;
+        string err;
+        if (!parseLogQuery(text, q, err)) { cout << RED << "❌ " << err << RESET << "\n"; return; }
+        showLogQuery(q);
     }
 
     void predictNextPeriod() const {
-        printHeader("🔮 NEXT PERIOD PREDICTION 🔮");
-        if (cycles.empty()) { cout << YELLOW << "Add at least one cycle to predict." << RESET << "\n"; return; }
-        int avgLen = averageCycleLength();
-        string lastStart = cycles.back().startDate;
-        string predictedNext = addDays(lastStart, avgLen);
-        cout << CYAN << "Average cycle length: " << avgLen << " days" << RESET << "\n";
-        cout << GREEN << "Next predicted period start: " << BOLD << predictedNext << RESET << "\n";
-        int daysLeft = daysFromTodayTo(predictedNext);
+        PT_TIMED("predictNextPeriod");
+        printHeader(PT_HEADER("🔮 NEXT PERIOD PREDICTION 🔮"));
+        Prediction p = prediction();
+        if (!p.valid) { cout << PT_LINE(Yellow, "Add at least one cycle to predict."); return; }
+        cout << CYAN << "Predicted cycle length (" << predictorName() << "): " << p.cycleLength << " days" << RESET << "\n";
+        cout << GREEN << "Next predicted period start: " << BOLD << p.nextStart << RESET << "\n";
+        cout << CYAN << "Estimated ovulation: " << p.ovulation << RESET << "\n";
+        cout << CYAN << "Fertile window: " << p.fertileFrom << " -> " << p.fertileTo << RESET << "\n";
+        int daysLeft = daysFromTodayTo(p.nextStart);
         if (daysLeft >= 0) cout << YELLOW << "Days left until next period: " << daysLeft << RESET << "\n";
         else cout << YELLOW << "Predicted date is in the past by " << -daysLeft << " day(s)." << RESET << "\n";
     }
 
-    void rebuildRemindersFromCycles() {
-        while (!reminders.empty()) reminders.pop();
-        if (!cycles.empty()) {
-            int avgLen = averageCycleLength();
-            string lastStart = cycles.back().startDate;
-            string predicted = addDays(lastStart, avgLen);
-            sys_time tp;
-            if (stringToTimePoint(predicted, tp)) {
-                pushReminder({tp, "Predicted next period: " + predicted});
+    void showReminders() {
+        PT_TIMED("showReminders");
+        printHeader(PT_HEADER("⏰ UPCOMING REMINDERS ⏰"));
+        unique_lock<shared_mutex> lock(mu);
+        if (remindersStale) refreshGeneratedReminders();
+        cleanupPastReminders();
+        Date now = today(), horizon = horizonEnd(now, horizonMonths);
+        // projected events up to the horizon, except the period the generated reminder covers
+        shared_ptr<const Projection> proj = horizonMonths > 0 ? currentProjection() : nullptr;
+        size_t pi = proj ? proj->firstIndexFrom(now) : 0;
+        auto nextProjected = [&]() -> optional<ProjectedEvent> {
+            if (!proj) return nullopt;
+            ProjectedEvent e = proj->event(pi);
+            if (e.kind == ProjectedKind::Period && e.from == predictedReminderDate && predictedReminderId) e = proj->event(++pi);
+            if (horizon < e.from) return nullopt;
+            return e;
+        };
+        optional<ProjectedEvent> pe = nextProjected();
+        if (manualReminders.empty() && generatedReminders.empty() && !pe) {
+            cout << PT_LINE(Yellow, "No upcoming reminders.");
+            return;
+        }
+        // merge the two sorted stores and the projection, stopping after the first ten
+        ReminderStore::Range m = manualReminders.upcoming(10), g = generatedReminders.upcoming(10);
+        const Reminder *mi = m.begin(), *gi = g.begin();
+        for (int i = 1; i <= 10 && (mi != m.end() || gi != g.end() || pe); ++i) {
+            const Reminder *r = nullptr;
+            if (mi != m.end() && (gi == g.end() || mi->when <= gi->when)) r = &*mi;
+            else if (gi != g.end()) r = &*gi;
+            if (pe && (!r || pe->from < r->when)) {
+                cout << i << ". " << projectedKindName(pe->kind) << " (projected): " << BOLD << pe->from << RESET << " -> "
+                     << BOLD << pe->to << RESET << " (in " << max(0, daysBetween(now, pe->from)) << " day(s))\n";
+                ++pi;
+                pe = nextProjected();
+                continue;
             }
+            if (r == mi) ++mi; else ++gi;
+            int daysAway = daysBetween(now, r->when);
+            cout << i << ". " << r->message << " (Date: " << BOLD << r->when << RESET << ", in " << daysAway
+                 << " day(s), id " << r->id << ")\n";
         }
     }
 
-    void showReminders() {
-        cleanupPastReminders();
-        printHeader("⏰ UPCOMING REMINDERS ⏰");
-        if (reminders.empty()) { cout << YELLOW << "No upcoming reminders." << RESET << "\n"; return; }
-        auto copyPQ = reminders;
-        int i = 1;
-        while (!copyPQ.empty() && i <= 10) {
-            Reminder r = copyPQ.top(); copyPQ.pop();
-            string dateStr = timePointToString(r.when);
-            int daysAway = daysFromTodayTo(dateStr);
-            cout << i << ". " << r.message << " (Date: " << BOLD << dateStr << RESET << ", in " << daysAway << " day(s))\n";
-            ++i;
+    // The projected schedule for the next `months` months, from the tracker's own model or
+    // from `whatIf` when given.
+    void showProjection(int months, const Predictor *whatIf = nullptr) const {
+        PT_TIMED("showProjection");
+        printHeader(PT_HEADER("📅 PROJECTED SCHEDULE 📅"));
+        shared_ptr<const Projection> proj = whatIf ? projectionWith(*whatIf) : projection();
+        if (!proj) {
+            cout << PT_LINE(Yellow, "No cycles recorded yet.");
+            return;
         }
+        Date now = today();
+        cout << "Model: " << proj->modelName() << ", cycle " << proj->cycleLength() << " days, period "
+             << proj->periodDays() << " days, next " << months << " month(s)\n";
+        OutSink out(cout, pageRows);
+        out.text(BOLD).cell("KIND", 16).cell("FROM", 12).cell("TO", 12).cell("CYCLE", 6).endRow();
+        out.text(RESET).text("----------------------------------------------").endRow();
+        proj->forEach(now, horizonEnd(now, months), [&](const ProjectedEvent &e) {
+            if (out.done()) return;
+            out.cell(projectedKindName(e.kind), 16).cell(e.from, 12).cell(e.to, 12).cell(e.cycle + 1, 6).endRow();
+        });
     }
 
     void addManualReminder() {
-        printHeader("➕ ADD MANUAL REMINDER ➕");
+        printHeader(PT_HEADER("➕ ADD MANUAL REMINDER ➕"));
         string date, msg; cout << "Enter date (YYYY-MM-DD): "; cin >> date;
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
         cout << "Enter reminder message: "; getline(cin, msg);
-        sys_time tp;
-        if (!stringToTimePoint(date, tp)) { cout << RED << "Invalid date format." << RESET << "\n"; return; }
-        pushReminder({tp, msg});
-        cout << GREEN << "Reminder added for " << date << RESET << "\n";
+        Date when;
+        if (!parseDate(date, when)) { cout << PT_LINE(Red, "Invalid date format."); return; }
+        uint32_t id = addReminder(when, msg);
+        cout << GREEN << "Reminder added for " << date << " (id " << id << ")" << RESET << "\n";
     }
 
-    void showAnalytics() const {
-        printHeader("📊 ANALYTICS SUMMARY 📊");
-        if (cycles.empty()) { cout << YELLOW << "No cycles to analyze." << RESET << "\n"; return; }
-        int sumDur = 0, sumLen = 0, countLen = 0;
-        int minDur = INT_MAX, maxDur = INT_MIN;
-        int minLen = INT_MAX, maxLen = INT_MIN;
-        for (const auto &c : cycles) {
-            sumDur += c.durationDays;
-            minDur = min(minDur, c.durationDays);
-            maxDur = max(maxDur, c.durationDays);
-            if (c.cycleLength > 0) {
-                sumLen += c.cycleLength; ++countLen;
-                minLen = min(minLen, c.cycleLength); maxLen = max(maxLen, c.cycleLength);
-            }
+    void removeReminderFromUser() {
+        printHeader(PT_HEADER("➖ REMOVE REMINDER ➖"));
+        uint32_t id;
+        cout << "Enter reminder id: ";
+        if (!(cin >> id)) {
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            cout << PT_LINE(Red, "Invalid id.");
+            return;
+        }
+        switch (removeReminder(id)) {
+            case EditResult::Ok: cout << GREEN << "Reminder " << id << " removed." << RESET << "\n"; break;
+            case EditResult::Conflict:
+                cout << YELLOW << "Reminder " << id << " is generated from your cycles and cannot be removed." << RESET << "\n";
+                break;
+            default: cout << RED << "No reminder with id " << id << "." << RESET << "\n";
         }
-        double avgDur = double(sumDur) / cycles.size();
-        cout << "Cycles recorded: " << cycles.size() << "\n";
+    }
+
+    void showAnalytics() const {
+        PT_TIMED("showAnalytics");
+        printHeader(PT_HEADER("📊 ANALYTICS SUMMARY 📊"));
+        auto sum = summary();
+        if (sum->cycleCount == 0) { cout << PT_LINE(Yellow, "No cycles to analyze."); return; }
+        cout << "Cycles recorded: " << sum->cycleCount << "\n";
         cout << fixed << setprecision(2);
-        cout << "Duration (days) - Avg: " << avgDur << ", Min: " << minDur << ", Max: " << maxDur << "\n";
-        if (countLen > 0) {
-            double avgLen = double(sumLen) / countLen;
-            cout << "Cycle length (days) - Avg: " << avgLen << ", Min: " << minLen << ", Max: " << maxLen << "\n";
+        cout << "Duration (days) - Avg: " << sum->durAvg << ", Min: " << sum->durMin
+             << ", Max: " << sum->durMax << ", Median: " << sum->durMedian << "\n";
+        if (sum->lengthCount > 0) {
+            cout << "Cycle length (days) - Avg: " << sum->lenAvg << ", Min: " << sum->lenMin
+                 << ", Max: " << sum->lenMax << ", Median: " << sum->lenMedian
+                 << ", Std dev: " << sum->lenStddev << "\n";
         } else cout << "Cycle length data insufficient (need >=2 cycles to compute lengths).\n";
+        if (sum->windowCount == 0) return;
+        cout << "Last " << sum->windowCount << " cycle length(s) - Median: " << sum->winMedian << ", Trimmed mean: "
+             << sum->winTrimmedMean << ", MAD: " << sum->winMad << ", Range: " << sum->winMin << "-" << sum->winMax << "\n";
+        cout << "Variability: robust std dev " << sum->winRobustSd() << " days ("
+             << 100 * sum->winRobustSd() / sum->winMedian << "% of the median)\n";
+        string flags;
+        auto flag = [&](const string &f) { flags += (flags.empty() ? "" : "; ") + f; };
+        if (isIrregular(*sum)) flag("irregular (lengths vary by more than 9 days)");
+        if (sum->winMedian < 21 || sum->winMedian > 35) flag("typical length outside 21-35 days");
+        if (sum->winOutliers) flag(to_string(sum->winOutliers) + " outlier cycle(s)");
+        if (flags.empty()) cout << GREEN << "Flags: none" << RESET << "\n";
+        else cout << YELLOW << "Flags: " << flags << RESET << "\n";
+    }
+
+    void saveAndExit() {
+        PT_TIMED("saveAndExit");
+        printHeader(PT_HEADER("💾 SAVING & EXITING"));
+        save();
+        cout << GREEN << "Data saved (changes journaled to " << journalFile << ")." << RESET << "\n";
+        cout << "Goodbye! 👋\n";
+    }
+};
+
+inline void BackgroundSaver::run() {
+    unique_lock<mutex> lock(mu);
+    while (!stopping) {
+        if (queue.empty()) { cv.wait(lock); continue; }
+        auto next = queue.begin();
+        if (next->first > Clock::now()) {
+            auto due = next->first; // the node can be erased while we sleep; begin() is re-read after
+            cv.wait_until(lock, due);
+            continue;
+        }
+        PeriodTracker *t = next->second;
+        queued.erase(t);
+        queue.erase(next);
+        busy = t;
+        lock.unlock();
+        optional<Clock::time_point> again = t->backgroundSave();
+        lock.lock();
+        busy = nullptr;
+        if (again) scheduleLocked(t, *again);
+        cv.notify_all();
+    }
+}
+
+// ---------- Multi-user store ----------
+// Serves many users from one process. Each user's files live in a shard directory
+// root/<hh>/<user>/ (hh = FNV-1a hash byte, to keep directories small). Trackers are
+// loaded on first use, outside the store lock so different users load in parallel;
+// once the estimated footprint exceeds the budget the least recently used ones that
+// nobody else holds are dropped. A dropped tracker is destroyed (and so flushed) after the
+// store lock is released; until it is, acquiring that user waits instead of loading a
+// second tracker over the same directory.
+class TrackerStore {
+    struct Slot {
+        shared_future<shared_ptr<PeriodTracker>> tracker; // ready once loaded
+        list<string>::iterator lruPos;
+        size_t bytes = 0;
+        size_t pins = 0; // acquire() calls waiting on `tracker` outside the lock
+        bool loaded = false;
+    };
+    struct Evicted {
+        string userId;
+        shared_ptr<PeriodTracker> tracker; // the last reference
+        promise<void> closed;
+    };
+    const string root;
+    const size_t budgetBytes;
+    const TrackerOptions options;
+    mutex mu;
+    unordered_map<string, Slot> resident;
+    list<string> lru; // front = most recently used
+    unordered_map<string, shared_future<void>> closing; // evicted, not yet destroyed
+    size_t usedBytes = 0;
+    function<void(PeriodTracker &)> onLoad;
+
+    void evictOverBudget(const string &keep, vector<Evicted> &dropped) {
+        for (auto it = lru.end(); usedBytes > budgetBytes && it != lru.begin();) {
+            --it;
+            auto slot = resident.find(*it);
+            if (*it == keep || !slot->second.loaded || slot->second.pins) continue;
+            const shared_ptr<PeriodTracker> &t = slot->second.tracker.get();
+            if (t.use_count() > 1) continue; // still in use elsewhere
+            Evicted &e = dropped.emplace_back();
+            e.userId = *it;
+            e.tracker = t;
+            closing.emplace(*it, e.closed.get_future().share());
+            usedBytes -= slot->second.bytes;
+            resident.erase(slot);
+            it = lru.erase(it);
+        }
+    }
+
+    void updateSize(const string &userId, size_t bytes, vector<Evicted> &dropped) {
+        auto it = resident.find(userId);
+        if (it == resident.end() || !it->second.loaded) return;
+        usedBytes = usedBytes - it->second.bytes + bytes;
+        it->second.bytes = bytes;
+        evictOverBudget(userId, dropped);
+    }
+
+    // Called without `mu`: the flushes in ~PeriodTracker must not hold up other users.
+    void close(vector<Evicted> &dropped) {
+        for (Evicted &e : dropped) {
+            e.tracker.reset();
+            {
+                lock_guard<mutex> lock(mu);
+                closing.erase(e.userId);
+            }
+            e.closed.set_value();
+        }
+    }
+
+public:
+    TrackerStore(string rootDir, size_t memoryBudgetBytes, TrackerOptions opts = TrackerOptions())
+        : root(move(rootDir)), budgetBytes(memoryBudgetBytes), options(move(opts)) {}
+    ~TrackerStore() { flushAll(); }
+
+    // Called on every tracker as it is loaded (e.g. to switch it into batch mode).
+    void setOnLoad(function<void(PeriodTracker &)> fn) { onLoad = move(fn); }
+
+    // Letters, digits, '-' and '_' only, so an id can never escape the store root.
+    static bool validUserId(string_view id) {
+        if (id.empty() || id.size() > 64) return false;
+        for (char c : id) if (!isalnum((unsigned char)c) && c != '-' && c != '_') return false;
+        return true;
+    }
+
+    string shardDir(const string &userId) const {
+        uint32_t h = 2166136261u;
+        for (unsigned char c : userId) { h ^= c; h *= 16777619u; }
+        char hex[3];
+        snprintf(hex, sizeof hex, "%02x", h & 0xff);
+        return root + "/" + hex + "/" + userId;
+    }
+
+    // Returns nullptr for an invalid id or when the shard directory cannot be created.
+    shared_ptr<PeriodTracker> acquire(const string &userId) {
+        if (!validUserId(userId)) return nullptr;
+        vector<Evicted> dropped;
+        unique_lock<mutex> lock(mu);
+        for (auto c = closing.find(userId); c != closing.end(); c = closing.find(userId)) {
+            shared_future<void> done = c->second; // still being flushed after an eviction
+            lock.unlock();
+            done.wait();
+            lock.lock();
+        }
+        auto it = resident.find(userId);
+        if (it != resident.end()) {
+            lru.splice(lru.begin(), lru, it->second.lruPos);
+            auto pending = it->second.tracker;
+            ++it->second.pins; // not evictable until we hold our own reference
+            lock.unlock();
+            shared_ptr<PeriodTracker> t = pending.get(); // waits if another thread is loading it
+            size_t bytes = t ? t->approxBytes() : 0;
+            lock.lock();
+            it = resident.find(userId);
+            if (it != resident.end()) --it->second.pins; // gone only if loading failed
+            if (!t) return nullptr;
+            updateSize(userId, bytes, dropped);
+            lock.unlock();
+            close(dropped);
+            return t;
+        }
+        promise<shared_ptr<PeriodTracker>> loading;
+        Slot slot;
+        slot.tracker = loading.get_future().share();
+        lru.push_front(userId);
+        slot.lruPos = lru.begin();
+        resident.emplace(userId, move(slot));
+        lock.unlock();
+
+        shared_ptr<PeriodTracker> t;
+        string dir = shardDir(userId);
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        if (!ec) {
+            t = make_shared<PeriodTracker>(dir, options);
+            if (onLoad) onLoad(*t);
+        }
+        size_t bytes = t ? t->approxBytes() : 0;
+        loading.set_value(t);
+
+        lock.lock();
+        it = resident.find(userId);
+        if (!t) {
+            lru.erase(it->second.lruPos);
+            resident.erase(it);
+            return nullptr;
+        }
+        it->second.loaded = true;
+        updateSize(userId, bytes, dropped);
+        lock.unlock();
+        close(dropped);
+        return t;
+    }
+
+    // Every user with a shard directory on disk, resident or not.
+    vector<string> listUsers() const {
+        vector<string> users;
+        error_code ec;
+        for (const auto &shard : filesystem::directory_iterator(root, ec)) {
+            if (!shard.is_directory()) continue;
+            for (const auto &user : filesystem::directory_iterator(shard.path(), ec)) {
+                string id = user.path().filename().string();
+                if (user.is_directory() && validUserId(id)) users.push_back(move(id));
+            }
+        }
+        return users;
+    }
+
+    size_t residentUsers() {
+        lock_guard<mutex> lock(mu);
+        return resident.size();
+    }
+
+    void flushAll() {
+        lock_guard<mutex> lock(mu);
+        for (auto &p : resident)
+            if (p.second.loaded) p.second.tracker.get()->save();
+    }
+
+    PopulationStats populationStats(size_t threads);
+};
+
+// ---------- Population analytics ----------
+// Runs f(index, worker) for every index in [0, n) on `threads` workers. Indices are
+// handed out in small chunks from a shared counter, so fast workers keep pulling work
+// and uneven per-item cost (users with long histories) still balances out.
+template <class F>
+void parallelFor(size_t n, size_t threads, F f) {
+    threads = max<size_t>(1, min(threads, n));
+    const size_t chunk = 16;
+    atomic<size_t> next{0};
+    auto worker = [&](size_t w) {
+        for (size_t b; (b = next.fetch_add(chunk)) < n;)
+            for (size_t i = b, e = min(n, b + chunk); i < e; ++i) f(i, w);
+    };
+    vector<thread> pool;
+    for (size_t w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto &t : pool) t.join();
+}
+
+// Fans out over every user in the store; each worker fills its own partial accumulator
+// and the partials are merged once at the end. Each partial is padded out to its own
+// cache lines, so workers never share one.
+inline PopulationStats TrackerStore::populationStats(size_t threads) {
+    struct alignas(64) Partial { PopulationStats stats; };
+    vector<string> users = listUsers();
+    vector<Partial> partials(max<size_t>(1, threads));
+    parallelFor(users.size(), partials.size(), [&](size_t i, size_t w) {
+        if (auto t = acquire(users[i])) t->accumulate(partials[w].stats);
+    });
+    PopulationStats total;
+    for (const auto &p : partials) total.merge(p.stats);
+    return total;
+}
+
+void printPopulationReport(const PopulationStats &p) {
+    cout << PT_THEMED(Theme::bold + Theme::cyan + FixedString("📊 POPULATION ANALYTICS") + Theme::reset + FixedString("\n"));
+    cout << "Users: " << p.users << ", with cycle lengths: " << p.usersWithLengths << ", cycles: " << p.cycles << "\n";
+    if (p.usersWithLengths == 0) { cout << PT_LINE(Yellow, "No cycle-length data."); return; }
+    cout << fixed << setprecision(2);
+    cout << "Cycle length (days) - Avg: " << p.meanLength() << ", P10: " << p.lengthPercentile(0.10)
+         << ", Median: " << p.lengthPercentile(0.50) << ", P90: " << p.lengthPercentile(0.90) << "\n";
+    cout << "Irregular users: " << p.irregularUsers << " (" << 100.0 * p.irregularUsers / p.usersWithLengths << "%)\n";
+    cout << "Duration histogram (days: cycles)\n";
+    for (int d = 0; d < PopulationStats::kDurationBuckets; ++d) {
+        if (!p.durationHist[d]) continue;
+        cout << "  " << setw(3) << d << (d == PopulationStats::kDurationBuckets - 1 ? "+" : " ") << ": " << p.durationHist[d] << "\n";
+    }
+}
+
+// ---------------- Batch mode ----------------
+// Non-interactive driver: one command per line, no menu, headers or prompts.
+//   add-cycle START END         delete-cycle START          undo / redo
+//   log DATE SYMPTOMS [| MOOD]  add-reminder DATE MESSAGE   remove-reminder ID
+//   cycles / logs / predict / analytics / reminders
+//   query TERMS                 (see parseLogQuery)
+//   predictor NAME              mean / recent / median / smooth
+//   projection [MONTHS] [NAME]  projected schedule (default: the reminder horizon), optionally
+//                               from another predictor without switching to it
+//   metrics json|prometheus     operation counters and latency histograms so far
+//   import FILE [csv|ndjson]    merge an interchange file (format from the extension if omitted)
+//   export FILE [csv|ndjson]    write cycles and logs, merged in date order
+//   user ID                     (with --store: switch to that user's tracker)
+// Blank lines and '#' comments are skipped. Errors go to stderr with their line number;
+// the journal is flushed once when the input ends.
+static const char *describe(EditResult r) {
+    switch (r) {
+        case EditResult::Nothing: return "nothing to apply";
+        case EditResult::EndBeforeStart: return "end date must be after start date";
+        case EditResult::Duplicate: return "a cycle with this start date is already recorded";
+        case EditResult::NotFound: return "not found";
+        case EditResult::Conflict: return "conflicts with an existing entry";
+        default: return "ok";
+    }
+}
+
+int runBatch(shared_ptr<PeriodTracker> current, TrackerStore *store, istream &in) {
+    if (current) current->setBatchMode(true);
+    if (store) store->setOnLoad([](PeriodTracker &t) { t.setBatchMode(true); });
+    string line;
+    size_t lineNo = 0, errors = 0;
+    auto fail = [&](const char *why) { cerr << "line " << lineNo << ": " << why << "\n"; ++errors; };
+    auto check = [&](EditResult r) {
+        if (r != EditResult::Ok && r != EditResult::Removed && r != EditResult::Restored && r != EditResult::LogChanged) fail(describe(r));
+    };
+    while (getline(in, line)) {
+        ++lineNo;
+        string_view rest = trim(line);
+        if (rest.empty() || rest[0] == '#') continue;
+        string_view cmd = nextWord(rest);
+        if (cmd == "user") {
+            if (!store) fail("'user' needs --store");
+            else if (!(current = store->acquire(string(rest)))) fail("invalid user id");
+            continue;
+        }
+        if (!current) { fail("no user selected"); continue; }
+        PeriodTracker &tracker = *current;
+        Date d1, d2;
+        if (cmd == "add-cycle") {
+            if (!parseDate(nextWord(rest), d1) || !parseDate(nextWord(rest), d2)) fail("invalid date");
+            else check(tracker.addCycle(d1, d2));
+        } else if (cmd == "delete-cycle") {
+            if (!parseDate(nextWord(rest), d1)) fail("invalid date");
+            else check(tracker.deleteCycle(d1));
+        } else if (cmd == "undo") check(tracker.undoLast(d1));
+        else if (cmd == "redo") check(tracker.redoLast(d1));
+        else if (cmd == "log") {
+            if (!parseDate(nextWord(rest), d1)) { fail("invalid date"); continue; }
+            size_t bar = rest.find('|');
+            string_view sym = trim(rest.substr(0, bar));
+            string_view mood = bar == string_view::npos ? string_view() : trim(rest.substr(bar + 1));
+            tracker.logDaily(d1, string(sym), string(mood));
+        } else if (cmd == "add-reminder") {
+            if (!parseDate(nextWord(rest), d1)) fail("invalid date");
+            else tracker.addReminder(d1, string(rest));
+        } else if (cmd == "remove-reminder") {
+            int id;
+            if (!parseInt(rest, id) || id <= 0) fail("invalid id");
+            else check(tracker.removeReminder(uint32_t(id)));
+        } else if (cmd == "cycles") tracker.displayCycles();
+        else if (cmd == "logs") tracker.displayDailyLogs();
+        else if (cmd == "query") {
+            LogQuery q;
+            string err;
+            if (!parseLogQuery(rest, q, err)) fail(err.c_str());
+            else tracker.showLogQuery(q);
+        }
+        else if (cmd == "predict") tracker.predictNextPeriod();
+        else if (cmd == "projection") {
+            int months = tracker.horizon();
+            string_view word = nextWord(rest);
+            if (!word.empty() && isdigit((unsigned char)word[0])) {
+                if (!parseInt(word, months) || months <= 0) { fail("invalid month count"); continue; }
+                word = nextWord(rest);
+            }
+            shared_ptr<const Predictor> whatIf;
+            if (!word.empty() && !(whatIf = makePredictor(word))) fail("unknown predictor");
+            else tracker.showProjection(months, whatIf.get());
+        }
+        else if (cmd == "metrics") {
+            if (!writeMetrics(cout, rest)) fail("unknown metrics format");
+        } else if (cmd == "predictor") {
+            if (auto p = makePredictor(rest)) tracker.setPredictor(move(p));
+            else fail("unknown predictor");
+        }
+        else if (cmd == "import" || cmd == "export") {
+            string path(nextWord(rest));
+            StreamFormat fmt;
+            if (path.empty()) fail("missing file name");
+            else if (!streamFormatFor(path, rest, fmt)) fail("unknown format; use csv or ndjson");
+            else if (cmd == "export") {
+                if (!tracker.exportFile(path, fmt)) fail("cannot write export file");
+            } else if (auto r = tracker.importFile(path, fmt)) {
+                cout << "Imported " << r->cycles << " cycle(s) and " << r->logs << " log(s) from " << path
+                     << " (" << r->duplicates << " duplicate(s), " << r->rejected << " rejected)\n";
+            } else fail("cannot open import file");
+        }
+        else if (cmd == "analytics") tracker.showAnalytics();
+        else if (cmd == "reminders") tracker.showReminders();
+        else fail("unknown command");
+    }
+    if (current) current->save();
+    if (store) store->flushAll();
+    cout.flush();
+    if (errors) cerr << "batch: " << errors << " error(s) in " << lineNo << " line(s)\n";
+    return errors ? 1 : 0;
+}
+
+// ---------------- Feed server ----------------
+// Minimal HTTP/1.1 server for calendar clients, one request per connection:
+//   GET /calendar.ics                 iCalendar feed
+//   GET /feed.json[?since=VERSION]    JSON feed, or only the changes since VERSION
+//   GET /metrics                      operation metrics (Prometheus text)
+// With --store, the feeds are under /users/ID/... for users that already exist. Both
+// feeds honour If-None-Match. Worker threads share one listening socket and serve the
+// pre-built responses from the tracker's feed cache.
+class FeedServer {
+    shared_ptr<PeriodTracker> single;
+    TrackerStore *store;
+    int fd = -1;
+    atomic<bool> stopping{false};
+    vector<thread> workers;
+
+    static constexpr size_t kMaxRequest = 8192;
+
+    static bool sendAll(int c, string_view data) {
+        while (!data.empty()) {
+            ssize_t n = send(c, data.data(), data.size(), MSG_NOSIGNAL);
+            if (n <= 0) { if (n < 0 && errno == EINTR) continue; return false; }
+            data.remove_prefix(size_t(n));
+        }
+        return true;
+    }
+
+    // Value of header `name` (case-insensitive) in the request head, or empty.
+    static string_view header(string_view head, string_view name) {
+        for (size_t pos = head.find("\r\n"); pos != string_view::npos;) {
+            size_t start = pos + 2, end = head.find("\r\n", start);
+            string_view line = head.substr(start, end == string_view::npos ? string_view::npos : end - start);
+            if (line.size() > name.size() && line[name.size()] == ':' &&
+                equal(name.begin(), name.end(), line.begin(), [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); }))
+                return trim(line.substr(name.size() + 1));
+            pos = end;
+        }
+        return {};
+    }
+
+    static string plain(const char *status, string_view text) { return httpResponse(status, "text/plain", "", text); }
+
+    shared_ptr<PeriodTracker> trackerFor(string_view &path) {
+        if (!store) return single;
+        if (path.substr(0, 7) != "/users/") return nullptr;
+        path.remove_prefix(7);
+        size_t slash = path.find('/');
+        string id(path.substr(0, slash));
+        path = slash == string_view::npos ? string_view() : path.substr(slash);
+        error_code ec;
+        if (!TrackerStore::validUserId(id) || !filesystem::exists(store->shardDir(id), ec)) return nullptr;
+        return store->acquire(id);
+    }
+
+    string respond(string_view head) {
+        string_view requestLine = head.substr(0, head.find("\r\n")), rest = requestLine;
+        string_view method = nextWord(rest), target = nextWord(rest);
+        if (method != "GET" && method != "HEAD") return plain("405 Method Not Allowed", "GET only\n");
+        size_t q = target.find('?');
+        string_view path = target.substr(0, q), query = q == string_view::npos ? string_view() : target.substr(q + 1);
+        if (path == "/metrics") {
+            ostringstream os;
+            writeMetrics(os, "prometheus");
+            return httpResponse("200 OK", "text/plain; version=0.0.4", "", os.str());
+        }
+        shared_ptr<PeriodTracker> t = trackerFor(path);
+        bool ics = path == "/calendar.ics";
+        if (!t || (!ics && path != "/feed.json")) return plain("404 Not Found", "not found\n");
+        shared_ptr<const Feed> f = t->feed();
+        string_view match = header(head, "If-None-Match");
+        if (match == "*" || (!match.empty() && match.find(f->etag) != string_view::npos)) return f->notModified;
+        if (!ics && query.substr(0, 6) == "since=") {
+            string_view since = query.substr(6, query.find('&') == string_view::npos ? string_view::npos : query.find('&') - 6);
+            if (auto delta = t->feedDelta(f, since)) return *delta;
+        }
+        return ics ? f->ics : f->json;
+    }
+
+    void handle(int c) {
+        PT_TIMED("serveRequest");
+        timeval tv{5, 0};
+        setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+        setsockopt(c, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+        string req;
+        char buf[2048];
+        size_t end;
+        while ((end = req.find("\r\n\r\n")) == string::npos) {
+            if (req.size() > kMaxRequest) { sendAll(c, plain("431 Request Header Fields Too Large", "")); return; }
+            ssize_t n = recv(c, buf, sizeof buf, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            req.append(buf, size_t(n));
+        }
+        string_view head(req.data(), end);
+        string response = respond(head);
+        if (head.substr(0, 5) == "HEAD ") response.resize(response.find("\r\n\r\n") + 4);
+        sendAll(c, response);
+    }
+
+public:
+    FeedServer(shared_ptr<PeriodTracker> tracker, TrackerStore *users) : single(move(tracker)), store(users) {}
+    // Wakes the workers out of accept() and waits for the requests in flight.
+    ~FeedServer() {
+        stopping = true;
+        if (fd >= 0) shutdown(fd, SHUT_RDWR);
+        for (thread &w : workers) w.join();
+        if (fd >= 0) close(fd);
+    }
+    FeedServer(const FeedServer &) = delete;
+    FeedServer &operator=(const FeedServer &) = delete;
+
+    // addr is an IPv4 address; false (with errno set) when it cannot be bound.
+    bool listen(const string &addr, uint16_t port) {
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        if (inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1) { errno = EINVAL; return false; }
+        if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) return false;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+        return bind(fd, (const sockaddr *)&sa, sizeof sa) == 0 && ::listen(fd, 512) == 0;
+    }
+
+    // Serves on `threads` background workers until destroyed.
+    void start(size_t threads) {
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] {
+                while (!stopping) {
+                    int c = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+                    if (c < 0) {
+                        if (!stopping && errno != EINTR && errno != ECONNABORTED) this_thread::sleep_for(chrono::milliseconds(10));
+                        continue;
+                    }
+                    handle(c);
+                    close(c);
+                }
+            });
+    }
+
+    // Blocks until the process is stopped.
+    void wait() { for (thread &w : workers) w.join(); workers.clear(); }
+};
+
+// ---------------- Data generator & benchmarks ----------------
+// Synthetic history for one user: cycles of 21-40 days (around 28, spread varying by user) and
+// logs on roughly 60% of days, ending today. Deterministic for a given seed. Returns the
+// cycle start dates.
+static vector<Date> generateUserData(const string &dir, int years, uint32_t seed) {
+    static const char *const symptoms[] = {"cramps", "headache", "bloating", "acne", "back pain", "fatigue", "nausea"};
+    static const char *const moods[] = {"happy", "calm", "tired", "sad", "irritable", "anxious"};
+    mt19937 rng(seed);
+    normal_distribution<double> lengthDist(28.0 + uniform_int_distribution<int>(-2, 2)(rng),
+                                           uniform_real_distribution<double>(1.0, 3.5)(rng));
+    uniform_int_distribution<int> durationDist(3, 7), pick(0, 99);
+    Date end = today(), day = addDays(end, -365 * years);
+    vector<Date> starts;
+    FILE *cf = fopen((dir + "/cycles.csv").c_str(), "wb");
+    FILE *lf = fopen((dir + "/daily_logs.csv").c_str(), "wb");
+    if (!cf || !lf) {
+        if (cf) fclose(cf);
+        if (lf) fclose(lf);
+        return starts;
+    }
+    for (Date start = day, prev; start < end;) {
+        int duration = durationDist(rng);
+        writeCycleRow(cf, CycleEntry(start, addDays(start, duration), duration, starts.empty() ? 0 : daysBetween(prev, start)));
+        starts.push_back(start);
+        prev = start;
+        start = addDays(start, clamp(int(lround(lengthDist(rng))), 21, 40));
+    }
+    string sym;
+    for (; day < end; day = addDays(day, 1)) {
+        if (pick(rng) >= 60) continue;
+        sym.clear();
+        for (int n = pick(rng) % 3; n > 0; --n) {
+            if (!sym.empty()) sym += "; ";
+            sym += symptoms[size_t(pick(rng)) % size(symptoms)];
+        }
+        writeLogRow(lf, day, sym, moods[size_t(pick(rng)) % size(moods)]);
     }
+    fclose(cf);
+    fclose(lf);
+    return starts;
+}
+
+// Fills a store layout (one shard directory per user, as TrackerStore expects) with
+// users named user000001, user000002, ...
+static bool generateStore(const string &root, size_t users, int years, size_t threads) {
+    TrackerStore layout(root, 0);
+    atomic<size_t> failed{0};
+    parallelFor(users, threads, [&](size_t i, size_t) {
+        char id[16];
+        snprintf(id, sizeof id, "user%06zu", i + 1);
+        string dir = layout.shardDir(id);
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        if (ec || generateUserData(dir, years, uint32_t(i + 1)).empty()) ++failed;
+    });
+    return failed == 0;
+}
 
-    void saveAndExit() { printHeader("💾 SAVING & EXITING"); saveData(); cout << GREEN << "Data saved (cycles.csv, daily_logs.csv)." << RESET << "\n"; cout << "Goodbye! 👋\n"; }
+// Swallows output so display paths can be timed without the terminal.
+struct NullBuffer : streambuf {
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char *, streamsize n) override { return n; }
 };
 
+// Repeats `body` (which does opsPerCall operations) for at least 300 ms after one
+// warm-up call and reports the mean time per operation.
+template <class F>
+static void runBench(const char *name, uint64_t opsPerCall, F &&body) {
+    using Clock = chrono::steady_clock;
+    body();
+    uint64_t calls = 0;
+    auto start = Clock::now(), now = start;
+    do { body(); ++calls; now = Clock::now(); } while (now - start < chrono::milliseconds(300));
+    double ns = chrono::duration<double, nano>(now - start).count() / double(calls * opsPerCall);
+    cout << left << setw(36) << name << right << fixed << setprecision(1) << setw(14) << ns << " ns/op"
+         << setw(12) << calls * opsPerCall << " ops\n" << flush;
+}
+
+// Times the core paths on one generated user in a scratch directory, which is removed
+// afterwards. Numbers are meant for before/after comparisons on the same machine.
+static int runBenchmarks(int years) {
+    char tmpl[] = "/tmp/ptbench.XXXXXX";
+    if (!mkdtemp(tmpl)) { cerr << "Cannot create a scratch directory\n"; return 1; }
+    const string dir = tmpl;
+    vector<Date> starts = generateUserData(dir, years, 42);
+    if (starts.size() < 2) { cerr << "Cannot generate benchmark data in " << dir << "\n"; return 1; }
+    cout << "Benchmark data: " << years << " years, " << starts.size() << " cycles\n";
+
+    NullBuffer null;
+    auto quiet = [&](auto &&f) { streambuf *old = cout.rdbuf(&null); f(); cout.rdbuf(old); };
+    volatile int64_t sink = 0;
+
+    vector<Date> dates;
+    mt19937 rng(7);
+    for (int i = 0; i < 4096; ++i) dates.push_back(Date(int32_t(rng() % 40000)));
+    runBench("daysBetween + addDays", dates.size(), [&] {
+        int64_t acc = 0;
+        for (size_t i = 1; i < dates.size(); ++i) acc += daysBetween(dates[i - 1], addDays(dates[i], 3));
+        sink = sink + acc;
+    });
+    char text[16];
+#ifndef PT_NO_METRICS
+    runBench("PT_TIMED scope", 1, [&] { PT_TIMED("bench.timer"); });
+#endif
+    runBench("today()", 1, [&] { sink = sink + today().days; });
+    runBench("formatDate + parseDate", dates.size(), [&] {
+        Date d;
+        for (Date x : dates) { formatDate(x, text); parseDate(string_view(text, 10), d); sink = sink + d.days; }
+    });
+
+    runBench("load (CSV, then snapshot rebuild)", 1, [&] {
+        remove((dir + "/tracker.snap").c_str());
+        PeriodTracker t(dir);
+    });
+    runBench("load (binary snapshot)", 1, [&] { PeriodTracker t(dir); });
+
+    { // destroyed (and so flushed) before the directory is removed
+        PeriodTracker tracker(dir);
+        tracker.setBatchMode(true);
+        runBench("saveData (CSV + snapshot)", 1, [&] { tracker.writeSnapshot(); });
+        const string exported = dir + "/export.csv";
+        runBench("exportFile (csv)", 1, [&] { tracker.exportFile(exported, StreamFormat::Csv); });
+        runBench("importFile (csv, all duplicates)", 1, [&] { tracker.importFile(exported, StreamFormat::Csv); });
+        auto mean = makePredictor("mean"), smooth = makePredictor("smooth");
+        runBench("prediction (recompute, mean)", 1, [&] { tracker.setPredictor(mean); sink = sink + tracker.prediction().cycleLength; });
+        runBench("prediction (recompute, smooth)", 1, [&] { tracker.setPredictor(smooth); sink = sink + tracker.prediction().cycleLength; });
+        runBench("prediction (cached)", 1, [&] { sink = sink + tracker.prediction().cycleLength; });
+        runBench("showAnalytics", 1, [&] { quiet([&] { tracker.showAnalytics(); }); });
+        runBench("showReminders", 1, [&] { quiet([&] { tracker.showReminders(); }); });
+        runBench("showProjection (24 months)", 1, [&] { quiet([&] { tracker.showProjection(24); }); });
+
+        Date middle = starts[starts.size() / 2];
+        Date d;
+        runBench("deleteCycle + undo", 2, [&] { tracker.deleteCycle(middle); tracker.undoLast(d); });
+        runBench("redo + undo", 2, [&] { tracker.redoLast(d); tracker.undoLast(d); });
+        LogQuery q;
+        string err;
+        parseLogQuery("headache phase:luteal", q, err);
+        runBench("queryLogs (headache, luteal)", 1, [&] { sink = sink + int64_t(tracker.queryLogs(q).size()); });
+        runBench("displayDailyLogs", 1, [&] { quiet([&] { tracker.displayDailyLogs(); }); });
+
+        tracker.save();
+    }
+    error_code ec;
+    filesystem::remove_all(dir, ec);
+    return 0;
+}
+
 // ---------------- Menu & main ----------------
+template <class Theme> constexpr auto renderMenu() {
+    return Theme::bold + FixedString("\n───────── 🌸 PERIOD TRACKER 🌸 ─────────\n") + Theme::reset
+         + FixedString("1. Add New Cycle\n"
+                       "2. Delete Cycle (by start date)\n"
+                       "3. Undo (last edit)\n"
+                       "4. Redo\n"
+                       "5. Log Daily Symptom & Mood\n"
+                       "6. View Cycle History\n"
+                       "7. Predict Next Period (only date)\n"
+                       "8. Reminders (show / add manual / remove)\n"
+                       "9. Analytics Summary\n"
+                       "10. Daily Logs (view / search)\n"
+                       "11. Save & Exit\n"
+                       "---------------------------------------------\n"
+                       "Enter choice (1-11): ");
+}
+
 void displayMenu() {
-    cout << BOLD << "\n───────── 🌸 PERIOD TRACKER 🌸 ─────────\n" << RESET;
-    cout << "1. Add New Cycle\n";
-    cout << "2. Delete Cycle (by start date)\n";
-    cout << "3. Undo (last add/delete)\n";
-    cout << "4. Redo\n";
-    cout << "5. Log Daily Symptom & Mood\n";
-    cout << "6. View Cycle History\n";
-    cout << "7. Predict Next Period (only date)\n";
-    cout << "8. Reminders (show) / Add manual reminder\n";
-    cout << "9. Analytics Summary\n";
-    cout << "10. View Daily Logs\n";
-    cout << "11. Save & Exit\n";
-    cout << "---------------------------------------------\n";
-    cout << "Enter choice (1-11): " << flush; // <-- flush so prompt shows before cin
-}
-
-int main() {
+    cout << PT_THEMED(renderMenu<Theme>()) << flush; // <-- flush so prompt shows before cin
+}
+
+// Usage: main [--store DIR [--budget-mb N] [--user ID] [--population [--threads N]]] [--undo-depth N]
+//             [--predictor mean|recent|median|smooth] [--save-debounce-ms N] [--horizon-months N]
+//             [--stats-window N]
+//             [--plain|--color] [--no-pager] [--metrics json|prometheus] [--batch FILE|-]    (--metrics: dump to stderr at exit)
+//             [--serve [ADDR:]PORT [--threads N]]    calendar feeds over HTTP (default address 127.0.0.1),
+//             served alongside the menu, after the --batch input, or on their own for a --store without --user
+//        main --generate DIR USERS YEARS     synthetic store for --store DIR
+//        main --bench [YEARS]                timings on one generated user (default 30 years)
+int main(int argc, char **argv) {
     ios::sync_with_stdio(false);
+    string storeRoot, userId, batchFile;
+    bool batch = false, population = false, pager = true, bench = false;
+    string generateRoot, metricsFormat, serveAddr;
+    size_t genUsers = 0;
+    int years = 30;
+    int color = -1; // -1 = only when stdout is a terminal
+    size_t budgetMb = 256, threads = max(1u, thread::hardware_concurrency());
+    TrackerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string_view a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--batch" && hasValue) { batch = true; batchFile = argv[++i]; }
+        else if (a == "--store" && hasValue) storeRoot = argv[++i];
+        else if (a == "--user" && hasValue) userId = argv[++i];
+        else if (a == "--budget-mb" && hasValue) budgetMb = strtoul(argv[++i], nullptr, 10);
+        else if (a == "--population") population = true;
+        else if (a == "--threads" && hasValue) threads = max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if (a == "--undo-depth" && hasValue) options.undoDepth = max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if (a == "--save-debounce-ms" && hasValue) options.saveDebounce = chrono::milliseconds(strtoul(argv[++i], nullptr, 10));
+        else if (a == "--stats-window" && hasValue) options.statsWindow = max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if (a == "--horizon-months" && hasValue) options.horizonMonths = min(600, max(0, atoi(argv[++i])));
+        else if (a == "--predictor" && hasValue) {
+            if (!(options.predictor = makePredictor(argv[++i]))) { cerr << "Unknown predictor; use one of " << kPredictorNames << "\n"; return 2; }
+        }
+        else if (a == "--plain") color = 0;
+        else if (a == "--color") color = 1;
+        else if (a == "--no-pager") pager = false;
+        else if (a == "--metrics" && hasValue) metricsFormat = argv[++i];
+        else if (a == "--serve" && hasValue) serveAddr = argv[++i];
+        else if (a == "--generate" && i + 3 < argc) {
+            generateRoot = argv[++i];
+            genUsers = strtoul(argv[++i], nullptr, 10);
+            years = atoi(argv[++i]);
+        } else if (a == "--bench") {
+            bench = true;
+            if (hasValue && isdigit((unsigned char)argv[i + 1][0])) years = atoi(argv[++i]);
+        } else {
+            cerr << "Usage: " << argv[0] << " [--store DIR [--budget-mb N] [--user ID] [--population [--threads N]]]"
+                 << " [--undo-depth N] [--predictor NAME] [--save-debounce-ms N] [--horizon-months N] [--stats-window N] [--plain|--color] [--no-pager] [--metrics json|prometheus] [--batch FILE|-] [--serve [ADDR:]PORT]\n"
+                 << "       " << argv[0] << " --generate DIR USERS YEARS | --bench [YEARS]\n";
+            return 2;
+        }
+    }
+    if (years <= 0 || years > 200) { cerr << "YEARS must be between 1 and 200\n"; return 2; }
+    if (!metricsFormat.empty() && metricsFormat != "json" && metricsFormat != "prometheus") { cerr << "Unknown metrics format: " << metricsFormat << "\n"; return 2; }
+    // Declared before the trackers so that their final saves are included in the dump.
+    struct MetricsAtExit {
+        string format;
+        ~MetricsAtExit() { if (!format.empty()) writeMetrics(cerr, format); }
+    } metricsAtExit{metricsFormat};
+    if (!generateRoot.empty()) {
+        if (!generateStore(generateRoot, genUsers, years, threads)) { cerr << "Generation failed under " << generateRoot << "\n"; return 1; }
+        cout << "Generated " << genUsers << " user(s) x " << years << " year(s) under " << generateRoot << "\n";
+        return 0;
+    }
+    colorOutput = color < 0 ? isatty(STDOUT_FILENO) && !getenv("NO_COLOR") : color == 1;
+    if (bench) return runBenchmarks(years);
+    static char outBuf[1 << 16];
+    if (batch) cout.rdbuf()->pubsetbuf(outBuf, sizeof outBuf);
+
+    options.readOnly = population; // the report only reads each user's files
+    unique_ptr<TrackerStore> store;
+    shared_ptr<PeriodTracker> current;
+    if (!storeRoot.empty()) {
+        store = make_unique<TrackerStore>(storeRoot, budgetMb << 20, options);
+        if (!userId.empty() && !(current = store->acquire(userId))) { cerr << "Invalid user id: " << userId << "\n"; return 2; }
+    } else current = make_shared<PeriodTracker>("", options);
+    if (population) {
+        if (!store) { cerr << "--population needs --store DIR\n"; return 2; }
+        printPopulationReport(store->populationStats(threads));
+        return 0;
+    }
+    // Declared after the trackers so that it stops before they are destroyed.
+    unique_ptr<FeedServer> server;
+    if (!serveAddr.empty()) {
+        size_t colon = serveAddr.rfind(':');
+        string host = colon == string::npos ? "127.0.0.1" : serveAddr.substr(0, colon);
+        int port;
+        if (!parseInt(string_view(serveAddr).substr(colon == string::npos ? 0 : colon + 1), port) || port <= 0 || port > 65535) {
+            cerr << "Invalid --serve port: " << serveAddr << "\n";
+            return 2;
+        }
+        server = make_unique<FeedServer>(store ? nullptr : current, store.get());
+        if (!server->listen(host, uint16_t(port))) { cerr << "Cannot listen on " << host << ":" << port << ": " << strerror(errno) << "\n"; return 1; }
+        server->start(threads);
+        cerr << "Serving calendar feeds on http://" << host << ":" << port << "/\n";
+    }
+
+    if (batch) {
+        int rc;
+        if (batchFile == "-") {
+            cin.tie(nullptr); // or every command read would flush the batch output
+            rc = runBatch(current, store.get(), cin);
+        }
+        else {
+            ifstream in(batchFile);
+            if (!in) { cerr << "Cannot open " << batchFile << "\n"; return 1; }
+            rc = runBatch(current, store.get(), in);
+        }
+        if (server) server->wait();
+        return rc;
+    }
+    if (!current && server) { server->wait(); return 0; }
+    if (!current) { cerr << "Interactive mode with --store needs --user ID\n"; return 2; }
     // re-tie cin to cout so prompts flush automatically before input
     cin.tie(&cout);
 
-    PeriodTracker tracker;
+    PeriodTracker &tracker = *current;
+    if (pager) tracker.setPageRows(terminalPageRows());
     bool running = true;
     while (running) {
         displayMenu();
@@ -420,17 +4402,26 @@ int main() {
             case 6: tracker.displayCycles(); break;
             case 7: tracker.predictNextPeriod(); break;
             case 8: {
-                cout << "a) Show reminders   b) Add manual reminder\nChoose (a/b): " << flush;
+                cout << "a) Show reminders   b) Add manual reminder   c) Remove reminder   d) Projected schedule\nChoose (a/b/c/d): " << flush;
                 char ch; cin >> ch;
                 if (ch == 'a') tracker.showReminders();
+                else if (ch == 'd') tracker.showProjection(max(1, tracker.horizon()));
                 else if (ch == 'b') tracker.addManualReminder();
-                else cout << RED << "Invalid option\n" << RESET;
+                else if (ch == 'c') tracker.removeReminderFromUser();
+                else cout << PT_LINE(Red, "Invalid option");
                 break;
             }
             case 9: tracker.showAnalytics(); break;
-            case 10: tracker.displayDailyLogs(); break;
+            case 10: {
+                cout << "a) View all logs   b) Search logs\nChoose (a/b): " << flush;
+                char ch; cin >> ch;
+                if (ch == 'a') tracker.displayDailyLogs();
+                else if (ch == 'b') tracker.searchLogsFromUser();
+                else cout << PT_LINE(Red, "Invalid option");
+                break;
+            }
             case 11: tracker.saveAndExit(); running = false; break;
-            default: cout << RED << "Invalid choice (1-11).\n" << RESET;
+            default: cout << PT_LINE(Red, "Invalid choice (1-11).");
         }
     }
     return 0;